@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// a minimal harness for the micro-benchmarks of the classes in src/dsp
+// The results are written to stdout as JSON, one object per measurement,
+// with the benchmark's name, its parameters and what was measured, so that
+// the output of two releases can be compared by a script.
+class Bench {
+public:
+  typedef std::vector<std::pair<std::string, double>> Values;
+
+  // Keep the compiler from optimizing away the results we don't look at.
+  static void sink(float x) {
+    static volatile float s = 0.f;
+    s = s + x;
+  }
+
+  // the time of one of the n iterations f does, in ns, the best of a few runs
+  // (after one run to warm up the caches)
+  template <typename F>
+  static double time(F f, int n, int runs = 5) {
+    f();
+    double best = 1.e300;
+    for (int r = 0; r < runs; r++) {
+      auto t0 = std::chrono::steady_clock::now();
+      f();
+      auto t1 = std::chrono::steady_clock::now();
+      double t = std::chrono::duration<double, std::nano>(t1 - t0).count();
+      if (t < best)
+        best = t;
+    }
+    return best / n;
+  }
+
+  void begin(const char* compiler, const char* flags, const char* kernels) {
+    printf("{\n  \"compiler\": \"%s\",\n  \"flags\": \"%s\",\n"
+      "  \"dspKernels\": \"%s\",\n  \"results\": [", compiler, flags,
+      kernels);
+  }
+
+  void report(const std::string& name, const Values& params,
+    const Values& metrics) {
+    printf("%s\n    { \"name\": \"%s\", \"params\": {", (first) ? "" : ",",
+      name.c_str());
+    print(params);
+    printf(" }");
+    if (!metrics.empty()) {
+      printf(",");
+      print(metrics);
+    }
+    printf(" }");
+    fflush(stdout);
+    first = false;
+  }
+
+  void end() {
+    printf("\n  ]\n}\n");
+  }
+
+private:
+  bool first = true;
+
+  static void print(const Values& values) {
+    for (size_t i = 0; i < values.size(); i++)
+      printf("%s \"%s\": %.6g", (i > 0) ? "," : "", values[i].first.c_str(),
+        values[i].second);
+  }
+};
+
+void benchFastMath(Bench& bench);
+void benchOscillators(Bench& bench);
+void benchSpectrum(Bench& bench);
+void benchPendulums(Bench& bench);
@@ -0,0 +1,35 @@
+# `make bench` builds the micro-benchmarks of the classes in src/dsp without
+# the Rack SDK, runs them and writes the results to stdout as JSON (the build
+# messages go to stderr), e.g. `make bench > bench.json`.
+# `make bench BENCH_ARGS="spectrum pendulums"` only runs those suites (see
+# bench/main.cpp).
+
+# the optimization flags Rack compiles plugins with (on x64)
+BENCH_FLAGS ?= -O3 -funsafe-math-optimizations -fno-omit-frame-pointer -march=nehalem
+BENCH_CXXFLAGS = -std=c++11 $(BENCH_FLAGS) -Isrc -DBENCH_FLAGS='"$(BENCH_FLAGS)"'
+BENCH_SOURCES = $(wildcard bench/*.cpp) $(wildcard src/dsp/*.cpp)
+BENCH_OBJECTS = $(patsubst %.cpp,build/bench/obj/%.o,$(BENCH_SOURCES))
+BENCH_TARGET = build/bench/bench
+
+# the variants of the DSP kernels, like in the Makefile
+build/bench/obj/src/dsp/DspKernelsScalar.o: BENCH_CXXFLAGS += -fno-tree-vectorize
+ifneq ($(findstring x86_64,$(shell $(CXX) -dumpmachine)),)
+build/bench/obj/src/dsp/DspKernelsAvx2.o: BENCH_CXXFLAGS += -mavx2 -mfma
+build/bench/obj/src/dsp/DspKernelsAvx512.o: BENCH_CXXFLAGS += -mavx512f -mavx2 -mfma
+endif
+
+.PHONY: bench bench-build
+
+bench: $(BENCH_TARGET)
+	@$(BENCH_TARGET) $(BENCH_ARGS)
+
+bench-build: $(BENCH_TARGET)
+
+$(BENCH_TARGET): $(BENCH_OBJECTS)
+	@echo "LD $@" >&2
+	@$(CXX) $(BENCH_CXXFLAGS) $^ -o $@ -pthread
+
+build/bench/obj/%.o: %.cpp $(wildcard bench/*.h) $(wildcard src/dsp/*.h)
+	@mkdir -p $(@D)
+	@echo "CXX $<" >&2
+	@$(CXX) $(BENCH_CXXFLAGS) -c $< -o $@
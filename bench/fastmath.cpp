@@ -0,0 +1,111 @@
+// the accuracy and speed of the approximations in src/dsp/FastMath.h,
+// compared to the standard library
+#include "Bench.h"
+#include "dsp/FastMath.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+static const int N = 4096;
+static const int REPEATS = 200;
+
+// the maximum error of f against the reference ref on [a, b]
+template <typename F, typename R>
+static double maxError(F f, R ref, double a, double b, bool relative) {
+  double e = 0.;
+  for (int i = 0; i <= 1000000; i++) {
+    float x = a + (b - a) * i / 1000000.;
+    double y = ref((double)x);
+    double d = abs(f(x) - y);
+    if (relative)
+      d /= abs(y);
+    e = max(e, d);
+  }
+  return e;
+}
+
+// the time per call in ns of f on the array x
+template <typename F>
+static double time(F f, const vector<float>& x) {
+  vector<float> y(N);
+  return Bench::time([&]() {
+    for (int r = 0; r < REPEATS; r++) {
+      f(x.data(), y.data(), N);
+      Bench::sink(y[r % N]);
+    }
+  }, N * REPEATS);
+}
+
+static vector<float> grid(float a, float b) {
+  vector<float> x(N);
+  for (int i = 0; i < N; i++)
+    x[i] = a + (b - a) * i / N;
+  return x;
+}
+
+static double sin2piRef(double x) {
+  return ::sin(2. * M_PI * x);
+}
+
+static double cos2piRef(double x) {
+  return ::cos(2. * M_PI * x);
+}
+
+static double pow10Ref(double x) {
+  return ::pow(10., x);
+}
+
+#define ROW(name, acc, f, ref, a, b, rel, x) \
+  bench.report("FastMath::" name, { { "accuracy", FastMath::acc } }, { \
+    { "max_error", maxError( \
+      [](float t) { return FastMath::f<FastMath::acc>(t); }, \
+      [](double t) { return ref(t); }, a, b, rel) }, \
+    { "ns_per_call", time([](const float* in, float* out, int n) { \
+      FastMath::f<FastMath::acc>(in, out, n); }, x) } })
+
+#define LIBM(name, f, x) \
+  bench.report("libm::" name, {}, { \
+    { "ns_per_call", time([](const float* in, float* out, int n) { \
+      for (int i = 0; i < n; i++) out[i] = f(in[i]); }, x) } })
+
+// The accuracy is reported as 0 (LOW), 1 (MEDIUM) or 2 (HIGH). The errors of
+// exp2 and pow10 are relative, the others absolute.
+void benchFastMath(Bench& bench) {
+  vector<float> x = grid(-M_PI, M_PI);
+  ROW("sin", LOW, sin, ::sin, -M_PI, M_PI, false, x);
+  ROW("sin", MEDIUM, sin, ::sin, -M_PI, M_PI, false, x);
+  ROW("sin", HIGH, sin, ::sin, -M_PI, M_PI, false, x);
+  LIBM("sin", sinf, x);
+  ROW("cos", LOW, cos, ::cos, -M_PI, M_PI, false, x);
+  ROW("cos", MEDIUM, cos, ::cos, -M_PI, M_PI, false, x);
+  ROW("cos", HIGH, cos, ::cos, -M_PI, M_PI, false, x);
+  LIBM("cos", cosf, x);
+
+  // phases in periods, over many periods
+  x = grid(-16.f, 16.f);
+  ROW("sin2pi", LOW, sin2pi, sin2piRef, -16., 16., false, x);
+  ROW("sin2pi", MEDIUM, sin2pi, sin2piRef, -16., 16., false, x);
+  ROW("sin2pi", HIGH, sin2pi, sin2piRef, -16., 16., false, x);
+  ROW("cos2pi", LOW, cos2pi, cos2piRef, -16., 16., false, x);
+  ROW("cos2pi", MEDIUM, cos2pi, cos2piRef, -16., 16., false, x);
+  ROW("cos2pi", HIGH, cos2pi, cos2piRef, -16., 16., false, x);
+
+  x = grid(-10.f, 10.f);
+  ROW("exp2", LOW, exp2, ::exp2, -125., 126., true, x);
+  ROW("exp2", MEDIUM, exp2, ::exp2, -125., 126., true, x);
+  ROW("exp2", HIGH, exp2, ::exp2, -125., 126., true, x);
+  LIBM("exp2", exp2f, x);
+
+  x = grid(-3.f, 3.f);
+  ROW("pow10", LOW, pow10, pow10Ref, -37., 37., true, x);
+  ROW("pow10", MEDIUM, pow10, pow10Ref, -37., 37., true, x);
+  ROW("pow10", HIGH, pow10, pow10Ref, -37., 37., true, x);
+  LIBM("pow10", exp10f, x);
+
+  x = grid(1.e-3f, 1.e3f);
+  ROW("log2", LOW, log2, ::log2, .25, 4., false, x);
+  ROW("log2", MEDIUM, log2, ::log2, .25, 4., false, x);
+  ROW("log2", HIGH, log2, ::log2, .25, 4., false, x);
+  LIBM("log2", log2f, x);
+}
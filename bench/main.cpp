@@ -0,0 +1,33 @@
+// micro-benchmarks of the classes in src/dsp, without Rack
+// Run them with `make bench`, see bench/bench.mk .
+#include "Bench.h"
+#include "dsp/DspKernels.h"
+#include <cstring>
+
+#ifndef BENCH_FLAGS
+#define BENCH_FLAGS ""
+#endif
+
+int main(int argc, char** argv) {
+  // optionally only the suites named on the command line
+  const char* suites[] = { "fastmath", "oscillators", "spectrum", "pendulums" };
+  void (*functions[])(Bench&) = {
+    benchFastMath, benchOscillators, benchSpectrum, benchPendulums
+  };
+
+  // like at plugin init
+  DspKernels::init();
+
+  Bench bench;
+  bench.begin(__VERSION__, BENCH_FLAGS,
+    DspKernels::getName(DspKernels::getIsa()));
+  for (int i = 0; i < 4; i++) {
+    bool run = argc < 2;
+    for (int j = 1; j < argc; j++)
+      run = run || strcmp(argv[j], suites[i]) == 0;
+    if (run)
+      functions[i](bench);
+  }
+  bench.end();
+  return 0;
+}
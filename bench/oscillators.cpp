@@ -0,0 +1,184 @@
+// the oscillators: AdditiveOscillator, UnisonOscillator, SineBank and
+// RatFuncOscillator
+#include "Bench.h"
+#include "dsp/AdditiveOscillator.h"
+#include "dsp/UnisonOscillator.h"
+#include "dsp/SineBank.h"
+#include "dsp/RatFuncOscillator.h"
+#include "dsp/RatFuncWavetable.h"
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+static const int SAMPLE_RATE = 48000;
+static const int SAMPLES = 20000;
+
+// a voice of Ad, with a spectrum of partials partials, smoothed and settled
+struct Voice {
+  CvBuffer buf;
+  Spectrum spec;
+  AdditiveOscillator osc;
+  UnisonOscillator uni;
+  CvBuffer::Mode mode = CvBuffer::LOW_HIGH;
+  int partialChan[127];
+
+  Voice(int partials, float stretch, bool stereo, float freq) {
+    for (int i = 0; i < 127; i++)
+      partialChan[i] = i % 2;
+    buf.init(256, 128, &mode);
+    spec.init(128, &buf, 2, partialChan);
+    spec.setSmoothCoeff(1.f / 64.f);
+    spec.setLowestHighest(1.f, 1.f + partials);
+    spec.setTilt(-.5f);
+    spec.setSieve(0.f);
+    spec.setStereoMode((stereo) ? Spectrum::SOFT_PAN : Spectrum::MONO);
+    spec.process();
+    for (int i = 0; i < 2000; i++)
+      spec.smoothen();
+    osc.init(SAMPLE_RATE, &spec);
+    osc.setStretch(stretch, AdditiveOscillator::CONTINUOUS);
+    osc.setFreq(freq);
+    uni.init(SAMPLE_RATE, &spec);
+    uni.setStretch(stretch);
+  }
+};
+
+static void benchAdditive(Bench& bench) {
+  const int partialsList[] = { 8, 32, 128 };
+  // With the integer stretch, the oscillator plays its settled spectrum from
+  // the wavetable (see AdditiveWavetable.h), which is rendered in the warm-up
+  // run. With the other one, it sums the sines.
+  const float stretchList[] = { 1.f, .5f };
+  const int voicesList[] = { 1, 4, 16 };
+  for (int partials : partialsList) {
+    for (float stretch : stretchList) {
+      for (int stereo = 0; stereo < 2; stereo++) {
+        for (int voices : voicesList) {
+          vector<unique_ptr<Voice>> v;
+          // low enough that no partials are left out for the Nyquist
+          // frequency
+          for (int c = 0; c < voices; c++)
+            v.emplace_back(new Voice(partials, stretch, stereo, 40.f + c));
+          double ns = Bench::time([&]() {
+            for (int i = 0; i < SAMPLES; i++) {
+              for (int c = 0; c < voices; c++) {
+                v[c]->spec.smoothen();
+                v[c]->osc.process();
+                Bench::sink(v[c]->osc.getWave(0));
+              }
+            }
+          }, SAMPLES, 3);
+          bench.report("AdditiveOscillator::process", {
+            { "partials", partials },
+            { "stretch", stretch },
+            { "stereo", stereo },
+            { "voices", voices } }, {
+            { "ns_per_sample", ns } });
+        }
+      }
+    }
+  }
+}
+
+// the kernel of AdditiveOscillator in all the variants the CPU supports
+// The variant is reported as in DspKernels::Isa: 0 (SCALAR), 1 (BASELINE),
+// 2 (AVX2) or 3 (AVX512).
+static void benchKernels(Bench& bench) {
+  Voice v(128, 1.f, true, 40.f);
+  for (int isa = 0; isa < DspKernels::ISAS_LEN; isa++) {
+    const DspKernels* kernels = DspKernels::get((DspKernels::Isa)isa);
+    if (!kernels)
+      continue;
+    for (int waves = 1; waves <= 2; waves++) {
+      float wave[2];
+      double ns = Bench::time([&]() {
+        for (int i = 0; i < SAMPLES; i++) {
+          kernels->additive(128, .3f, .5f, .99f, v.spec.getAmps(), 128, waves,
+            wave);
+          Bench::sink(wave[0]);
+        }
+      }, SAMPLES);
+      bench.report("DspKernels::additive", {
+        { "isa", isa },
+        { "partials", 128 },
+        { "stereo", waves - 1 } }, {
+        { "ns_per_call", ns } });
+    }
+  }
+}
+
+static void benchUnison(Bench& bench) {
+  const int stacksList[] = { 2, 4, 8 };
+  for (int stacks : stacksList) {
+    Voice v(128, 1.f, true, 40.f);
+    v.uni.setStacks(stacks, 20.f);
+    v.uni.setFreq(40.f);
+    double ns = Bench::time([&]() {
+      for (int i = 0; i < SAMPLES; i++) {
+        v.spec.smoothen();
+        v.uni.process();
+        Bench::sink(v.uni.getWave(0));
+      }
+    }, SAMPLES, 3);
+    bench.report("UnisonOscillator::process", {
+      { "partials", 128 },
+      { "stacks", stacks } }, {
+      { "ns_per_sample", ns } });
+  }
+}
+
+static void benchSineBank(Bench& bench) {
+  const int voicesList[] = { 1, 4, 16 };
+  for (int voices : voicesList) {
+    SineBank sines;
+    sines.setSampleRate(SAMPLE_RATE);
+    sines.setChannels(voices);
+    for (int c = 0; c < voices; c++)
+      sines.setFreq(c, 100.f * (c + 1));
+    double ns = Bench::time([&]() {
+      for (int i = 0; i < SAMPLES; i++) {
+        sines.process();
+        Bench::sink(sines.getWave(0));
+      }
+    }, SAMPLES);
+    bench.report("SineBank::process", { { "voices", voices } },
+      { { "ns_per_sample", ns } });
+  }
+}
+
+// The anti-aliasing mode is reported as 0 (LIMIT_PARAMS), 1 (ANTIDERIVATIVE)
+// or 2 (WAVETABLE).
+static void benchRatFunc(Bench& bench) {
+  const float a = .3f, b = .6f, c = .8f;
+  shared_ptr<RatFuncWavetable> wavetable = RatFuncWavetable::acquire();
+  // Wait until the wavetables we need are built (in the background).
+  float wave[2];
+  for (int i = 0; i < 1000 && !wavetable->read(a, b, c, 4, 0.f, wave); i++)
+    this_thread::sleep_for(chrono::milliseconds(10));
+
+  for (int mode = 0; mode < 3; mode++) {
+    RatFuncOscillator osc;
+    osc.setSampleRate(SAMPLE_RATE);
+    osc.setWavetable(wavetable.get());
+    osc.setAntiAliasing((RatFuncOscillator::AntiAliasing)mode);
+    osc.setParams(a, b, c);
+    osc.setFreq(440.f);
+    double ns = Bench::time([&]() {
+      for (int i = 0; i < SAMPLES; i++) {
+        osc.process();
+        Bench::sink(osc.getWave(0) + osc.getWave(1));
+      }
+    }, SAMPLES);
+    bench.report("RatFuncOscillator::process", { { "antiAliasing", mode } },
+      { { "ns_per_sample", ns } });
+  }
+}
+
+void benchOscillators(Bench& bench) {
+  benchAdditive(bench);
+  benchKernels(bench);
+  benchUnison(bench);
+  benchSineBank(bench);
+  benchRatFunc(bench);
+}
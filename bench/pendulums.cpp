@@ -0,0 +1,57 @@
+// the pendulums of Sjoegele: DoublePendulumBank and ChainPendulumBank
+#include "Bench.h"
+#include "dsp/DoublePendulumBank.h"
+#include "dsp/ChainPendulumBank.h"
+
+static const int SAMPLE_RATE = 48000;
+static const int SAMPLES = 20000;
+
+// The integrator is reported as 0 (SEMI_IMPLICIT_EULER) or 1 (RK4). The
+// pendulums swing wildly (started upside down), so they take several
+// substeps per sample, like in Sjoegele at high pitch.
+template <typename Bank>
+static double time(Bank& bank, int voices, DoublePendulumBank::Integrator integrator) {
+  bank.setSampleRate(SAMPLE_RATE);
+  bank.setChannels(voices);
+  bank.setIntegrator(integrator);
+  for (int c = 0; c < voices; c++) {
+    bank.setLength(c, 1.f);
+    bank.setGravity(c, 9.8f * 1000.f);
+    bank.setCOF(c, 0.f);
+    bank.init(c);
+  }
+  float dt = 1.f / SAMPLE_RATE;
+  return Bench::time([&]() {
+    for (int i = 0; i < SAMPLES; i++)
+      bank.process(dt);
+  }, SAMPLES, 3);
+}
+
+void benchPendulums(Bench& bench) {
+  const int voicesList[] = { 1, 4, 16 };
+  for (int integrator = 0; integrator < 2; integrator++) {
+    for (int voices : voicesList) {
+      DoublePendulumBank pendulums;
+      double ns = time(pendulums, voices,
+        (DoublePendulumBank::Integrator)integrator);
+      bench.report("DoublePendulumBank::process", {
+        { "integrator", integrator },
+        { "voices", voices } }, {
+        { "ns_per_sample", ns } });
+    }
+  }
+
+  const int linksList[] = { 3, 5, 8 };
+  for (int links : linksList) {
+    for (int voices : voicesList) {
+      ChainPendulumBank chains;
+      chains.setLinks(links);
+      double ns = time(chains, voices, DoublePendulumBank::RK4);
+      bench.report("ChainPendulumBank::process", {
+        { "integrator", DoublePendulumBank::RK4 },
+        { "links", links },
+        { "voices", voices } }, {
+        { "ns_per_sample", ns } });
+    }
+  }
+}
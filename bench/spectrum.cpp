@@ -0,0 +1,128 @@
+// the control-rate classes of Ad and Adje: Spectrum and CvBuffer
+#include "Bench.h"
+#include "dsp/Spectrum.h"
+
+static const int CALLS = 20000;
+
+// The sieve is reported as in Ad: positive values keep the primes, negative
+// ones sieve them too. The CV buffer mode is 0 (LOW_HIGH), 1 (HIGH_LOW) or
+// 2 (RANDOM).
+static void benchProcess(Bench& bench) {
+  const float sieveList[] = { 0.f, 2.5f, -10.f };
+  int partialChan[127];
+  for (int i = 0; i < 127; i++)
+    partialChan[i] = i % 2;
+  for (float sieve : sieveList) {
+    for (int cvBufferOn = 0; cvBufferOn < 2; cvBufferOn++) {
+      for (int stereo = 0; stereo < 2; stereo++) {
+        CvBuffer::Mode mode = CvBuffer::LOW_HIGH;
+        CvBuffer buf;
+        buf.init(256, 128, &mode);
+        buf.setOn(cvBufferOn);
+        buf.setLowestHighest(1.f, 128.f);
+        buf.setDelayRel(.5f);
+        for (int i = 0; i < 256; i++)
+          buf.push((float)(i % 7) / 7.f);
+        buf.process();
+        Spectrum spec;
+        spec.init(128, &buf, 2, partialChan);
+        spec.setLowestHighest(1.f, 128.f);
+        spec.setTilt(-.5f);
+        spec.setKeepPrimes(sieve >= 0.f);
+        spec.setSieve((sieve >= 0.f) ? sieve : 31.f + sieve);
+        spec.setComb(.3f);
+        spec.setStereoMode((stereo) ? Spectrum::SOFT_PAN : Spectrum::MONO);
+        double ns = Bench::time([&]() {
+          for (int i = 0; i < CALLS; i++) {
+            spec.process();
+            Bench::sink(spec.ampsAre0());
+          }
+        }, CALLS);
+        bench.report("Spectrum::process", {
+          { "partials", 128 },
+          { "sieve", sieve },
+          { "cvBuffer", cvBufferOn },
+          { "stereo", stereo } }, {
+          { "ns_per_call", ns } });
+      }
+    }
+  }
+}
+
+static void benchSmoothen(Bench& bench) {
+  int partialChan[127];
+  for (int i = 0; i < 127; i++)
+    partialChan[i] = i % 2;
+  for (int stereo = 0; stereo < 2; stereo++) {
+    CvBuffer::Mode mode = CvBuffer::LOW_HIGH;
+    CvBuffer buf;
+    buf.init(256, 128, &mode);
+    Spectrum spec;
+    spec.init(128, &buf, 2, partialChan);
+    spec.setSmoothCoeff(1.f / 64.f);
+    spec.setLowestHighest(1.f, 128.f);
+    spec.setStereoMode((stereo) ? Spectrum::SOFT_PAN : Spectrum::MONO);
+    // Two spectra to alternate between: smoothen() returns early once the
+    // amplitudes have settled (after about 730 calls at this coefficient),
+    // so we keep them moving. (The switches, every 512 calls, cost a few
+    // percent of the time.)
+    Spectrum::Result results[2];
+    spec.setTilt(-.5f);
+    spec.process();
+    spec.getResult(results[0]);
+    spec.setTilt(-.2f);
+    spec.process();
+    spec.getResult(results[1]);
+    double ns = Bench::time([&]() {
+      for (int i = 0; i < CALLS; i++) {
+        if ((i & 511) == 0)
+          spec.setResult(results[(i >> 9) & 1]);
+        spec.smoothen();
+        Bench::sink(spec.getAmp(1));
+      }
+    }, CALLS);
+    bench.report("Spectrum::smoothen", {
+      { "partials", 128 },
+      { "stereo", stereo } }, {
+      { "ns_per_call", ns } });
+  }
+}
+
+static void benchCvBuffer(Bench& bench) {
+  for (int m = 0; m < 3; m++) {
+    CvBuffer::Mode mode = (CvBuffer::Mode)m;
+    CvBuffer buf;
+    buf.init(4 * 750, 128, &mode);
+    buf.setOn(true);
+    buf.setLowestHighest(1.f, 128.f);
+    buf.setDelayRel(.5f);
+
+    double nsPush = Bench::time([&]() {
+      for (int i = 0; i < CALLS; i++)
+        buf.push((float)(i & 7));
+    }, CALLS);
+    double nsProcess = Bench::time([&]() {
+      for (int i = 0; i < CALLS; i++)
+        buf.process();
+    }, CALLS);
+    // reading all the partials, like Spectrum::process() does
+    double nsRead = Bench::time([&]() {
+      for (int i = 0; i < CALLS / 16; i++) {
+        float sum = 0.f;
+        for (int j = 0; j < 128; j++)
+          sum += buf.getValue(j);
+        Bench::sink(sum);
+      }
+    }, CALLS / 16);
+    bench.report("CvBuffer", { { "mode", m } }, {
+      { "push_ns_per_call", nsPush },
+      { "process_ns_per_call", nsProcess },
+      { "read_128_ns_per_call", nsRead } });
+  }
+}
+
+void benchSpectrum(Bench& bench) {
+  benchProcess(bench);
+  benchSmoothen(bench);
+  benchCvBuffer(bench);
+}
@@ -0,0 +1,38 @@
+# the minimax polynomials of src/dsp/FastMath.h
+# Fitted with Lawson's algorithm (iteratively reweighted least squares), which
+# converges to the minimax polynomial on the grid.
+import numpy as np
+
+def lawson(basis, f, x, weight=None, iters=3000):
+  A = np.stack([b(x) for b in basis], 1)
+  y = f(x)
+  w = np.ones_like(x) / len(x)
+  rel = weight(x) if weight else np.ones_like(x)
+  for _ in range(iters):
+    s = np.sqrt(w)
+    c = np.linalg.lstsq(A * (s * rel)[:, None], y * s * rel, rcond=None)[0]
+    e = np.abs((A @ c - y) * rel)
+    w = w * e
+    w /= w.sum()
+  return c, e.max()
+
+def show(name, deg, c, e):
+  print(name, deg, ', '.join('%.8g' % v for v in c), 'error %.2g' % e)
+
+# sin(x) = x*p(x^2) on [-pi, pi], absolute error
+x = np.linspace(0, np.pi, 20001)
+for deg in (7, 9, 11):
+  basis = [(lambda k: lambda t: t**(2*k+1))(k) for k in range(deg//2+1)]
+  show('sin', deg, *lawson(basis, np.sin, x))
+
+# 2^f = p(f) on [0, 1], relative error
+x = np.linspace(0, 1, 20001)
+for deg in (3, 4, 5):
+  basis = [(lambda k: lambda t: t**k)(k) for k in range(deg+1)]
+  show('exp2', deg, *lawson(basis, np.exp2, x, lambda t: np.exp2(-t)))
+
+# log2(m) = t*p(t) with t = m-1 on [1, 2], absolute error
+x = np.linspace(1, 2, 20001)
+for deg in (4, 5, 7):
+  basis = [(lambda k: lambda t: (t-1)**(k+1))(k) for k in range(deg)]
+  show('log2', deg, *lawson(basis, np.log2, x))
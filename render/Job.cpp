@@ -0,0 +1,206 @@
+#include "Render.h"
+#include <cmath>
+
+using namespace std;
+
+bool Curve::fromJson(const Json& json, string& error) {
+  points.clear();
+  if (json.type == Json::NUMBER || json.type == Json::BOOLEAN) {
+    points.push_back({ 0., (float)json.toNumber() });
+    return true;
+  }
+  if (json.type == Json::ARRAY && !json.array.empty()) {
+    for (const Json& point : json.array) {
+      if (point.type != Json::ARRAY || point.array.size() != 2
+        || !point.array[0].isNumber() || !point.array[1].isNumber()) {
+        error = "a breakpoint should be [t, v]";
+        return false;
+      }
+      double t = point.array[0].number;
+      if (!points.empty() && t < points.back().first) {
+        error = "the breakpoints should be in order of time";
+        return false;
+      }
+      points.push_back({ t, (float)point.array[1].number });
+    }
+    return true;
+  }
+  error = "expected a number or breakpoints [[t, v], ...]";
+  return false;
+}
+
+namespace {
+
+int find(const vector<string>& names, const string& name) {
+  for (size_t i = 0; i < names.size(); i++) {
+    if (names[i] == name)
+      return i;
+  }
+  return -1;
+}
+
+template <typename T>
+int find(const vector<pair<string, T>>& names, const string& name) {
+  for (size_t i = 0; i < names.size(); i++) {
+    if (names[i].first == name)
+      return i;
+  }
+  return -1;
+}
+
+// the member key of json, or else of defaults
+const Json* get(const Json& json, const Json* defaults, const char* key) {
+  const Json* value = json.get(key);
+  if (!value && defaults)
+    value = defaults->get(key);
+  return value;
+}
+
+// Set the curves named in the object json[key]. The names are looked up in
+// names, and unknown ones are an error, to catch typos.
+template <typename Names>
+bool setCurves(const Json* json, const char* key, const Names& names,
+  vector<Curve>& curves, vector<bool>* given, string& error) {
+  if (!json)
+    return true;
+  if (json->type != Json::OBJECT) {
+    error = string("\"") + key + "\" should be an object";
+    return false;
+  }
+  for (const pair<string, Json>& member : json->object) {
+    int i = find(names, member.first);
+    if (i < 0) {
+      error = string("unknown ") + key + " \"" + member.first + "\"";
+      return false;
+    }
+    if (!curves[i].fromJson(member.second, error)) {
+      error = key + string(" \"") + member.first + "\": " + error;
+      return false;
+    }
+    if (given)
+      (*given)[i] = true;
+  }
+  return true;
+}
+
+} // namespace
+
+// The members of defaults (if any) are used for what the job doesn't give,
+// and for the params, options and inputs the job doesn't name.
+bool Job::fromJson(const Json& json, const Json* defaults, string& error) {
+  if (json.type != Json::OBJECT) {
+    error = "a job should be an object";
+    return false;
+  }
+
+  const Json* moduleJ = get(json, defaults, "module");
+  const ModuleInfo* modules[] = { &adInfo, &funsInfo, &sjoegeleInfo };
+  for (const ModuleInfo* m : modules) {
+    if (moduleJ && moduleJ->str == m->name)
+      module = m;
+  }
+  if (!module) {
+    error = "\"module\" should be \"Ad\", \"Funs\" or \"Sjoegele\"";
+    return false;
+  }
+
+  const Json* outputJ = get(json, defaults, "output");
+  if (!outputJ || outputJ->type != Json::STRING) {
+    error = "\"output\" should be the path of the WAV file";
+    return false;
+  }
+  output = outputJ->str;
+
+  const Json* sampleRateJ = get(json, defaults, "sampleRate");
+  if (sampleRateJ)
+    sampleRate = sampleRateJ->toNumber();
+  if (sampleRate < 1000 || sampleRate > 768000) {
+    error = "\"sampleRate\" should be between 1000 and 768000";
+    return false;
+  }
+  const Json* durationJ = get(json, defaults, "duration");
+  if (!durationJ || !durationJ->isNumber() || durationJ->number <= 0.) {
+    error = "\"duration\" should be a positive number of seconds";
+    return false;
+  }
+  frames = (int)ceil(durationJ->number * sampleRate);
+  const Json* voicesJ = get(json, defaults, "voices");
+  if (voicesJ)
+    voices = voicesJ->toNumber();
+  if (voices < 1 || voices > 16) {
+    error = "\"voices\" should be between 1 and 16";
+    return false;
+  }
+  const Json* seedJ = get(json, defaults, "seed");
+  if (seedJ)
+    seed = (uint32_t)seedJ->toNumber();
+  const Json* mixVoicesJ = get(json, defaults, "mixVoices");
+  if (mixVoicesJ)
+    mixVoices = mixVoicesJ->toNumber() != 0.;
+
+  params.clear();
+  for (const pair<string, float>& p : module->params)
+    params.push_back(Curve(p.second));
+  if (!setCurves(defaults ? defaults->get("params") : nullptr, "params",
+      module->params, params, nullptr, error)
+    || !setCurves(json.get("params"), "params", module->params, params,
+      nullptr, error))
+    return false;
+
+  // The options are numbers, but they may be constant curves just as well.
+  vector<Curve> optionCurves;
+  for (const pair<string, double>& o : module->options)
+    optionCurves.push_back(Curve(o.second));
+  if (!setCurves(defaults ? defaults->get("options") : nullptr, "options",
+      module->options, optionCurves, nullptr, error)
+    || !setCurves(json.get("options"), "options", module->options,
+      optionCurves, nullptr, error))
+    return false;
+  options.clear();
+  for (const Curve& curve : optionCurves)
+    options.push_back(curve.at(0.));
+
+  vector<Curve> jobInputs(module->inputs.size());
+  inputPatched.assign(module->inputs.size(), false);
+  if (!setCurves(defaults ? defaults->get("inputs") : nullptr, "inputs",
+      module->inputs, jobInputs, &inputPatched, error)
+    || !setCurves(json.get("inputs"), "inputs", module->inputs, jobInputs,
+      &inputPatched, error))
+    return false;
+  inputs.assign(voices, jobInputs);
+  const Json* voiceInputsJ = get(json, defaults, "voiceInputs");
+  if (voiceInputsJ) {
+    if (voiceInputsJ->type != Json::ARRAY
+      || (int)voiceInputsJ->array.size() > voices) {
+      error = "\"voiceInputs\" should be an array of at most one object per "
+        "voice";
+      return false;
+    }
+    for (size_t c = 0; c < voiceInputsJ->array.size(); c++) {
+      if (!setCurves(&voiceInputsJ->array[c], "inputs", module->inputs,
+          inputs[c], &inputPatched, error))
+        return false;
+    }
+  }
+
+  outputs.clear();
+  const Json* outputsJ = get(json, defaults, "outputs");
+  if (outputsJ) {
+    if (outputsJ->type != Json::ARRAY || outputsJ->array.empty()) {
+      error = "\"outputs\" should be an array of output names";
+      return false;
+    }
+    for (const Json& o : outputsJ->array) {
+      int i = find(module->outputs, o.str);
+      if (i < 0) {
+        error = "unknown output \"" + o.str + "\"";
+        return false;
+      }
+      outputs.push_back(i);
+    }
+  } else {
+    for (const string& o : module->defaultOutputs)
+      outputs.push_back(find(module->outputs, o));
+  }
+  return true;
+}
@@ -0,0 +1,201 @@
+#include "Json.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+const Json* Json::get(const string& key) const {
+  for (const pair<string, Json>& member : object) {
+    if (member.first == key)
+      return &member.second;
+  }
+  return nullptr;
+}
+
+namespace {
+
+// a recursive descent parser, which stops at the first error
+struct Parser {
+  const string& text;
+  size_t pos = 0;
+  string error;
+
+  Parser(const string& text) : text(text) {}
+
+  bool fail(const char* what) {
+    // the line and column, for the error message
+    int line = 1;
+    size_t lineStart = 0;
+    for (size_t i = 0; i < pos && i < text.size(); i++) {
+      if (text[i] == '\n') {
+        line++;
+        lineStart = i + 1;
+      }
+    }
+    error = string(what) + " at line " + to_string(line) + ", column "
+      + to_string(pos - lineStart + 1);
+    return false;
+  }
+
+  void skipSpace() {
+    while (pos < text.size() && strchr(" \t\r\n", text[pos]))
+      pos++;
+  }
+
+  bool literal(const char* word) {
+    size_t n = strlen(word);
+    if (text.compare(pos, n, word) != 0)
+      return fail("unexpected character");
+    pos += n;
+    return true;
+  }
+
+  bool parseString(string& s) {
+    // (we're at the opening quote)
+    pos++;
+    while (pos < text.size() && text[pos] != '"') {
+      char ch = text[pos++];
+      if (ch != '\\') {
+        s += ch;
+        continue;
+      }
+      if (pos >= text.size())
+        break;
+      ch = text[pos++];
+      switch (ch) {
+        case 'n': s += '\n'; break;
+        case 't': s += '\t'; break;
+        case 'r': s += '\r'; break;
+        case 'b': s += '\b'; break;
+        case 'f': s += '\f'; break;
+        case 'u': {
+          // only the code points of a single UTF-16 unit, as UTF-8
+          if (pos + 4 > text.size())
+            return fail("bad escape");
+          unsigned u = strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+          pos += 4;
+          if (u < 0x80)
+            s += (char)u;
+          else if (u < 0x800) {
+            s += (char)(0xc0 | (u >> 6));
+            s += (char)(0x80 | (u & 0x3f));
+          } else {
+            s += (char)(0xe0 | (u >> 12));
+            s += (char)(0x80 | ((u >> 6) & 0x3f));
+            s += (char)(0x80 | (u & 0x3f));
+          }
+          break;
+        }
+        default: s += ch;
+      }
+    }
+    if (pos >= text.size())
+      return fail("unterminated string");
+    pos++;
+    return true;
+  }
+
+  bool parseValue(Json& value) {
+    skipSpace();
+    if (pos >= text.size())
+      return fail("unexpected end");
+    char ch = text[pos];
+    if (ch == '{') {
+      value.type = Json::OBJECT;
+      pos++;
+      skipSpace();
+      if (pos < text.size() && text[pos] == '}') {
+        pos++;
+        return true;
+      }
+      while (true) {
+        skipSpace();
+        if (pos >= text.size() || text[pos] != '"')
+          return fail("expected a key");
+        pair<string, Json> member;
+        if (!parseString(member.first))
+          return false;
+        skipSpace();
+        if (pos >= text.size() || text[pos] != ':')
+          return fail("expected ':'");
+        pos++;
+        if (!parseValue(member.second))
+          return false;
+        value.object.push_back(member);
+        skipSpace();
+        if (pos < text.size() && text[pos] == ',') {
+          pos++;
+          continue;
+        }
+        if (pos < text.size() && text[pos] == '}') {
+          pos++;
+          return true;
+        }
+        return fail("expected ',' or '}'");
+      }
+    }
+    if (ch == '[') {
+      value.type = Json::ARRAY;
+      pos++;
+      skipSpace();
+      if (pos < text.size() && text[pos] == ']') {
+        pos++;
+        return true;
+      }
+      while (true) {
+        value.array.push_back(Json());
+        if (!parseValue(value.array.back()))
+          return false;
+        skipSpace();
+        if (pos < text.size() && text[pos] == ',') {
+          pos++;
+          continue;
+        }
+        if (pos < text.size() && text[pos] == ']') {
+          pos++;
+          return true;
+        }
+        return fail("expected ',' or ']'");
+      }
+    }
+    if (ch == '"') {
+      value.type = Json::STRING;
+      return parseString(value.str);
+    }
+    if (ch == 't' || ch == 'f') {
+      value.type = Json::BOOLEAN;
+      value.boolean = ch == 't';
+      return literal((value.boolean) ? "true" : "false");
+    }
+    if (ch == 'n') {
+      value.type = Json::NUL;
+      return literal("null");
+    }
+    const char* begin = text.c_str() + pos;
+    char* end;
+    value.type = Json::NUMBER;
+    value.number = strtod(begin, &end);
+    if (end == begin)
+      return fail("unexpected character");
+    pos += end - begin;
+    return true;
+  }
+};
+
+} // namespace
+
+bool Json::parse(const string& text, Json& value, string& error) {
+  Parser parser(text);
+  value = Json();
+  if (!parser.parseValue(value)) {
+    error = parser.error;
+    return false;
+  }
+  parser.skipSpace();
+  if (parser.pos < text.size()) {
+    parser.fail("trailing characters");
+    error = parser.error;
+    return false;
+  }
+  return true;
+}
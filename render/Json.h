@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+// a minimal JSON value and parser, just enough for the job files of the
+// renderer (Rack's jansson isn't available without the SDK)
+class Json {
+public:
+  enum Type {
+    NUL,
+    BOOLEAN,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT
+  };
+
+  Type type = NUL;
+  bool boolean = false;
+  double number = 0.;
+  std::string str;
+  std::vector<Json> array;
+  std::vector<std::pair<std::string, Json>> object;
+
+  // the member with the given key, or nullptr
+  const Json* get(const std::string& key) const;
+
+  bool isNumber() const { return type == NUMBER; }
+  // numbers and booleans as a number
+  double toNumber() const { return (type == BOOLEAN) ? boolean : number; }
+
+  // Parse text into value. On failure, error tells what and where.
+  static bool parse(const std::string& text, Json& value,
+    std::string& error);
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Json.h"
+
+// the offline renderer: renders jobs described in JSON with the classes in
+// src/dsp, without Rack, see render/main.cpp for the format of the jobs
+
+// a parameter value or a CV over time: a constant, or breakpoints (t, v) with
+// t in seconds, linearly interpolated and held before the first and after
+// the last
+class Curve {
+private:
+  std::vector<std::pair<double, float>> points;
+
+public:
+  Curve(float value = 0.f) { points.push_back({ 0., value }); }
+
+  // a number, or an array of [t, v] pairs with increasing t
+  bool fromJson(const Json& json, std::string& error);
+
+  float at(double t) const {
+    if (points.size() == 1 || t <= points[0].first)
+      return points[0].second;
+    if (t >= points.back().first)
+      return points.back().second;
+    // the first breakpoint after t
+    size_t lo = 0;
+    size_t hi = points.size() - 1;
+    while (hi - lo > 1) {
+      size_t mid = (lo + hi) / 2;
+      if (points[mid].first > t)
+        hi = mid;
+      else
+        lo = mid;
+    }
+    const std::pair<double, float>& p0 = points[lo];
+    const std::pair<double, float>& p1 = points[hi];
+    return p0.second + (float)((t - p0.first) / (p1.first - p0.first))
+      * (p1.second - p0.second);
+  }
+};
+
+struct Job;
+
+// what the renderer knows about a module: the names of its knobs (with their
+// defaults), inputs, outputs and menu options (with their defaults, named
+// like in the module's patch JSON), and how to render it
+struct ModuleInfo {
+  std::string name;
+  std::vector<std::pair<std::string, float>> params;
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+  std::vector<std::pair<std::string, double>> options;
+  // the outputs we write when the job doesn't say
+  std::vector<std::string> defaultOutputs;
+  // whether each voice can be rendered on its own, or all the voices have
+  // to be rendered together (like the pendulums of Sjoegele, which share
+  // their number of substeps)
+  bool independentVoices;
+  // Render the voices [voice0, voice0 + voices) of the whole job. out has
+  // one buffer of job.frames samples per voice and output of the module,
+  // voice by voice; it's nullptr for the outputs which aren't written
+  // (which count as unpatched).
+  void (*render)(const Job& job, int voice0, int voices, float* const* out);
+};
+
+extern const ModuleInfo adInfo;
+extern const ModuleInfo funsInfo;
+extern const ModuleInfo sjoegeleInfo;
+
+struct Job {
+  const ModuleInfo* module = nullptr;
+  std::string output;
+  int sampleRate = 48000;
+  int frames = 0;
+  int voices = 1;
+  uint32_t seed = 0;
+  // whether the voices are summed in the WAV file, or each voice gets its
+  // own channels
+  bool mixVoices = true;
+
+  // all indexed like in the ModuleInfo
+  std::vector<Curve> params;
+  std::vector<double> options;
+  // the inputs of each voice; an input counts as patched if it's given for
+  // the job or for any of its voices
+  std::vector<std::vector<Curve>> inputs;
+  std::vector<bool> inputPatched;
+  std::vector<int> outputs;
+
+  bool fromJson(const Json& json, const Json* defaults, std::string& error);
+
+  double time(int frame) const { return (double)frame / sampleRate; }
+  // the seed for the random numbers of a voice
+  uint32_t voiceSeed(int voice) const {
+    return seed * 2654435761u + 40503u * (uint32_t)(voice + 1);
+  }
+};
+
+bool writeWav(const std::string& path, int sampleRate, int channels,
+  int frames, const float* interleaved, std::string& error);
@@ -0,0 +1,60 @@
+#include "Render.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+void put16(FILE* f, uint16_t x) {
+  unsigned char b[2] = { (unsigned char)x, (unsigned char)(x >> 8) };
+  fwrite(b, 1, 2, f);
+}
+
+void put32(FILE* f, uint32_t x) {
+  unsigned char b[4] = { (unsigned char)x, (unsigned char)(x >> 8),
+    (unsigned char)(x >> 16), (unsigned char)(x >> 24) };
+  fwrite(b, 1, 4, f);
+}
+
+} // namespace
+
+// a WAV file of 32-bit float samples, in volts, like the voltages in Rack
+// (so a full-scale wave is +-5.)
+bool writeWav(const string& path, int sampleRate, int channels, int frames,
+  const float* interleaved, string& error) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    error = "can't open " + path + ": " + strerror(errno);
+    return false;
+  }
+  uint32_t dataSize = (uint32_t)frames * channels * 4;
+  fwrite("RIFF", 1, 4, f);
+  put32(f, 4 + 26 + 12 + 8 + dataSize);
+  fwrite("WAVE", 1, 4, f);
+  // the fmt chunk (18 bytes, as the format isn't PCM)
+  fwrite("fmt ", 1, 4, f);
+  put32(f, 18);
+  // WAVE_FORMAT_IEEE_FLOAT
+  put16(f, 3);
+  put16(f, channels);
+  put32(f, sampleRate);
+  put32(f, sampleRate * channels * 4);
+  put16(f, channels * 4);
+  put16(f, 32);
+  put16(f, 0);
+  // the fact chunk, which non-PCM formats should have
+  fwrite("fact", 1, 4, f);
+  put32(f, 4);
+  put32(f, frames);
+  fwrite("data", 1, 4, f);
+  put32(f, dataSize);
+  // (the samples are little endian on all the platforms Rack runs on)
+  fwrite(interleaved, 4, (size_t)frames * channels, f);
+  bool ok = !ferror(f);
+  ok &= fclose(f) == 0;
+  if (!ok)
+    error = "can't write " + path;
+  return ok;
+}
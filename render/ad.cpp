@@ -0,0 +1,274 @@
+// Ad, one voice at a time, like Ad::process() does it
+#include "Render.h"
+#include "dsp/AdditiveOscillator.h"
+#include "dsp/UnisonOscillator.h"
+#include "dsp/SineBank.h"
+#include "dsp/FastMath.h"
+#include "dsp/AdControl.h"
+#include "dsp/ControlRate.h"
+#include <memory>
+
+using namespace std;
+
+namespace {
+
+enum ParamId {
+  PITCH_PARAM,
+  STRETCH_PARAM,
+  PARTIALS_PARAM,
+  TILT_PARAM,
+  SIEVE_PARAM,
+  CVBUFFER_DELAY_PARAM,
+  FMAMT_PARAM,
+  STRETCH_ATT_PARAM,
+  PARTIALS_ATT_PARAM,
+  TILT_ATT_PARAM,
+  SIEVE_ATT_PARAM,
+  RESET_PARAM
+};
+enum InputId {
+  VPOCT_INPUT,
+  FM_INPUT,
+  STRETCH_INPUT,
+  PARTIALS_INPUT,
+  TILT_INPUT,
+  SIEVE_INPUT,
+  CVBUFFER_INPUT,
+  CVBUFFER_DELAY_INPUT,
+  CVBUFFER_CLOCK_INPUT,
+  RESET_INPUT
+};
+enum OutputId {
+  SUM_L_OUTPUT,
+  SUM_R_OUTPUT,
+  FUND_OUTPUT,
+  OUTPUTS_LEN
+};
+enum OptionId {
+  PITCH_QUANT_OPTION,
+  STRETCH_QUANT_OPTION,
+  STEREO_MODE_OPTION,
+  CVBUFFER_MODE_OPTION,
+  EMPTY_ON_RESET_OPTION,
+  UNISON_OPTION,
+  UNISON_DETUNE_OPTION,
+  CONTROL_RATE_OPTION
+};
+
+// the state of one voice
+struct Voice {
+  CvBuffer::Mode cvBufferMode;
+  CvBuffer buf;
+  Spectrum spec;
+  AdditiveOscillator osc;
+  UnisonOscillator uni;
+  SineBank fundOsc;
+  AdControl::Voice state;
+};
+
+// Ad::getControlJob(), with the knobs and inputs of the job at time t
+void getControlJob(const Job& job, const vector<Curve>& in, double t,
+  Voice& v, Spectrum::StereoMode stereoMode, AdControl::Job& controlJob) {
+  AdControl::Inputs controlIn;
+  controlIn.partials = job.params[PARTIALS_PARAM].at(t);
+  controlIn.tilt = job.params[TILT_PARAM].at(t);
+  controlIn.sieve = job.params[SIEVE_PARAM].at(t);
+  controlIn.cvBufferDelay = job.params[CVBUFFER_DELAY_PARAM].at(t);
+  controlIn.partialsAtt = job.params[PARTIALS_ATT_PARAM].at(t);
+  controlIn.tiltAtt = job.params[TILT_ATT_PARAM].at(t);
+  controlIn.sieveAtt = job.params[SIEVE_ATT_PARAM].at(t);
+  controlIn.partialsCv = in[PARTIALS_INPUT].at(t);
+  controlIn.tiltCv = in[TILT_INPUT].at(t);
+  controlIn.sieveCv = in[SIEVE_INPUT].at(t);
+  controlIn.cvBufferDelayCv = in[CVBUFFER_DELAY_INPUT].at(t);
+  controlIn.cvBufferPatched = job.inputPatched[CVBUFFER_INPUT];
+  controlIn.cvBuffer = in[CVBUFFER_INPUT].at(t);
+  controlIn.clockPatched = job.inputPatched[CVBUFFER_CLOCK_INPUT];
+  controlIn.clock = in[CVBUFFER_CLOCK_INPUT].at(t);
+
+  AdControl::getJob(controlIn, stereoMode, controlJob);
+  v.state.getPending(controlJob);
+}
+
+void renderVoice(const Job& job, int c, float* const* out) {
+  int sampleRate = job.sampleRate;
+  ControlRate controlRate = (ControlRate)min(
+    max((int)job.options[CONTROL_RATE_OPTION], 0), CONTROL_RATES_LEN - 1);
+  int blockSize = getBlockSize(controlRate, sampleRate);
+  int blockPhase = AdControl::getBlockPhase(c, blockSize);
+
+  int pitchQuant = job.options[PITCH_QUANT_OPTION];
+  AdditiveOscillator::StretchQuant stretchQuant =
+    (AdditiveOscillator::StretchQuant)(int)job.options[STRETCH_QUANT_OPTION];
+  bool emptyOnReset = job.options[EMPTY_ON_RESET_OPTION] != 0.;
+  int unison = min(max((int)job.options[UNISON_OPTION], 1),
+    UnisonOscillator::MAX_STACKS);
+
+  // (too big for the stack)
+  unique_ptr<Voice> voice(new Voice);
+  Voice& v = *voice;
+  v.cvBufferMode = (CvBuffer::Mode)(int)job.options[CVBUFFER_MODE_OPTION];
+  v.buf.init(getCvBufferSize(blockSize, sampleRate), 128, &v.cvBufferMode);
+  v.buf.seed(job.voiceSeed(c));
+  v.spec.init(128, &v.buf, 2, Spectrum::PARTIAL_CHAN[c % 2]);
+  v.spec.setSmoothCoeff(1.f / (float)blockSize);
+  v.osc.init(sampleRate, &v.spec);
+  v.uni.init(sampleRate, &v.spec);
+  v.uni.setStacks(unison, job.options[UNISON_DETUNE_OPTION]);
+  v.fundOsc.setSampleRate(sampleRate);
+  v.fundOsc.setChannels(1);
+
+  const vector<Curve>& in = job.inputs[c];
+  bool runSum = out[SUM_L_OUTPUT] || out[SUM_R_OUTPUT];
+  bool runFund = out[FUND_OUTPUT];
+  Spectrum::StereoMode stereoMode = (out[SUM_R_OUTPUT]) ?
+    (Spectrum::StereoMode)(int)job.options[STEREO_MODE_OPTION] :
+    Spectrum::MONO;
+
+  // as after adding the module
+  v.state.reset(true);
+  int blockCounter = 0;
+
+  float pitchKnob = 0.f;
+  float stretchKnob = 0.f;
+  float stretchAtt = 0.f;
+  float fmAmt = 0.f;
+
+  for (int n = 0; n < job.frames; n++) {
+    double t = job.time(n);
+    if (blockCounter == 0) {
+      pitchKnob = job.params[PITCH_PARAM].at(t);
+      if (pitchQuant == 2)
+        pitchKnob = round(pitchKnob);
+      else if (pitchQuant == 1)
+        pitchKnob = round(12.f * pitchKnob) / 12.f;
+      stretchKnob = job.params[STRETCH_PARAM].at(t);
+      stretchAtt = .4f * job.params[STRETCH_ATT_PARAM].at(t);
+      fmAmt = FastMath::exp2<FastMath::MEDIUM>(
+        5.f * job.params[FMAMT_PARAM].at(t)) - 1.f;
+    }
+
+    float pitch = 16.35159783128741466737f
+      * FastMath::exp2(pitchKnob + in[VPOCT_INPUT].at(t));
+    float stretch = stretchKnob + stretchAtt * in[STRETCH_INPUT].at(t);
+    float freq = (1.f + .2f * in[FM_INPUT].at(t) * fmAmt) * pitch;
+
+    bool resetSignal = job.params[RESET_PARAM].at(t) > 0.f
+      || in[RESET_INPUT].at(t) > 2.5f;
+    // Ad::reset(c, emptyOnReset)
+    if (resetSignal && !v.state.isResetting()) {
+      v.state.reset(emptyOnReset);
+      v.osc.reset();
+      v.uni.reset();
+      v.fundOsc.reset(0);
+      if (emptyOnReset)
+        v.spec.set0();
+    } else {
+      if (!resetSignal)
+        v.state.release();
+
+      if (blockCounter == blockPhase) {
+        AdControl::Job controlJob;
+        getControlJob(job, in, t, v, stereoMode, controlJob);
+        AdControl::runJob(controlJob, v.spec, v.buf);
+        v.state.jobDone();
+      }
+
+      v.osc.setStretch(stretch, stretchQuant);
+      v.osc.setFreq(freq);
+      if (unison > 1) {
+        v.uni.setStretch(v.osc.getStretch());
+        v.uni.setFreq(freq);
+      }
+
+      v.fundOsc.setFreq(0, v.state.getFundMult(v.spec.getLowest(),
+        v.osc.getStretch()) * pitch);
+    }
+
+    if (v.state.checkSilence(v.spec.ampsAre0())) {
+      v.osc.reset();
+      v.uni.reset();
+    }
+
+    float left = 0.f;
+    float right = 0.f;
+    if (runSum)
+      v.spec.smoothen();
+    if (!runSum || v.spec.isSilent()) {
+      int skip = v.state.sleep(blockCounter == blockPhase);
+      if (skip > 0) {
+        v.osc.skip(skip);
+        v.uni.skip(skip);
+      }
+    } else {
+      int skip = v.state.wake();
+      if (skip > 0) {
+        v.osc.skip(skip);
+        v.uni.skip(skip);
+      }
+      if (unison > 1) {
+        v.uni.process();
+        left = 5.f * v.uni.getWave(0);
+        right = 5.f * v.uni.getWave(1);
+      } else {
+        v.osc.process();
+        left = 5.f * v.osc.getWave(0);
+        right = 5.f * v.osc.getWave(1);
+      }
+    }
+    if (out[SUM_L_OUTPUT])
+      out[SUM_L_OUTPUT][n] = left;
+    if (out[SUM_R_OUTPUT])
+      out[SUM_R_OUTPUT][n] = right;
+
+    // (When the fundamental isn't written, its phase doesn't matter.)
+    if (runFund) {
+      v.fundOsc.process();
+      out[FUND_OUTPUT][n] = 5.f * v.fundOsc.getWave(0);
+    }
+
+    blockCounter++;
+    blockCounter %= blockSize;
+  }
+}
+
+void render(const Job& job, int voice0, int voices, float* const* out) {
+  for (int c = voice0; c < voice0 + voices; c++)
+    renderVoice(job, c, out + (c - voice0) * OUTPUTS_LEN);
+}
+
+} // namespace
+
+const ModuleInfo adInfo = {
+  "Ad",
+  {
+    { "pitch", 4.f },
+    { "stretch", 1.f },
+    { "partials", 0.f },
+    { "tilt", -.5f },
+    { "sieve", 0.f },
+    { "cvBufferDelay", 0.f },
+    { "fmAmt", 0.f },
+    { "stretchAtt", 0.f },
+    { "partialsAtt", 0.f },
+    { "tiltAtt", 0.f },
+    { "sieveAtt", 0.f },
+    { "reset", 0.f }
+  },
+  { "vOct", "fm", "stretch", "partials", "tilt", "sieve", "cvBuffer",
+    "cvBufferDelay", "cvBufferClock", "reset" },
+  { "sumL", "sumR", "fund" },
+  {
+    { "pitchQuant", 0. },
+    { "stretchQuant", 0. },
+    { "stereoMode", 1. },
+    { "cvBufferMode", 0. },
+    { "emptyOnReset", 0. },
+    { "unison", 1. },
+    { "unisonDetune", 20. },
+    { "controlRate", 2. }
+  },
+  { "sumL", "sumR" },
+  true,
+  render
+};
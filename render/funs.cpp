@@ -0,0 +1,141 @@
+// Funs, one voice at a time, like Funs::process() does it
+#include "Render.h"
+#include "dsp/RatFuncOscillator.h"
+#include "dsp/RatFuncWavetable.h"
+#include "dsp/FastMath.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+enum ParamId {
+  PITCH_PARAM,
+  A_PARAM,
+  B_PARAM,
+  C_PARAM,
+  A_ATT_PARAM,
+  B_ATT_PARAM,
+  C_ATT_PARAM
+};
+enum InputId {
+  VPOCT_INPUT,
+  A_INPUT,
+  B_INPUT,
+  C_INPUT
+};
+enum OutputId {
+  WAVE1_OUTPUT,
+  WAVE2_OUTPUT,
+  OUTPUTS_LEN
+};
+enum OptionId {
+  PITCH_QUANT_OPTION,
+  ANTI_ALIASING_OPTION
+};
+
+// In the module, the oscillators fall back on the plain waves while the
+// wavetables are still being built in the background. That would make the
+// output depend on the timing, so here we build all of them first.
+shared_ptr<RatFuncWavetable> getWavetable() {
+  static mutex m;
+  static shared_ptr<RatFuncWavetable> wavetable;
+  lock_guard<mutex> lock(m);
+  if (wavetable)
+    return wavetable;
+  wavetable = RatFuncWavetable::acquire();
+  const int g = RatFuncWavetable::GRID - 1;
+  float wave[2];
+  bool ready = false;
+  while (!ready) {
+    ready = true;
+    for (int i = 0; i <= g; i++) {
+      for (int j = 0; j <= g; j++) {
+        for (int k = 0; k <= g; k++)
+          ready &= wavetable->read((float)i / g, (float)j / g, (float)k / g,
+            0, 0.f, wave);
+      }
+    }
+    if (!ready)
+      this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  return wavetable;
+}
+
+void renderVoice(const Job& job, int ch, RatFuncWavetable* wavetable,
+  float* const* out) {
+  int pitchQuant = job.options[PITCH_QUANT_OPTION];
+  RatFuncOscillator osc;
+  osc.setSampleRate(job.sampleRate);
+  osc.setWavetable(wavetable);
+  osc.setAntiAliasing(
+    (RatFuncOscillator::AntiAliasing)(int)job.options[ANTI_ALIASING_OPTION]);
+
+  const vector<Curve>& in = job.inputs[ch];
+  for (int n = 0; n < job.frames; n++) {
+    double t = job.time(n);
+    float pitch = job.params[PITCH_PARAM].at(t);
+    if (pitchQuant == 2)
+      pitch = round(pitch);
+    else if (pitchQuant == 1)
+      pitch = round(12.f * pitch) / 12.f;
+    pitch += in[VPOCT_INPUT].at(t);
+    pitch = 16.35159783128741466737f * FastMath::exp2(pitch);
+
+    float a = job.params[A_PARAM].at(t)
+      + .1f * job.params[A_ATT_PARAM].at(t) * in[A_INPUT].at(t);
+    float b = job.params[B_PARAM].at(t)
+      + .1f * job.params[B_ATT_PARAM].at(t) * in[B_INPUT].at(t);
+    float c = job.params[C_PARAM].at(t)
+      + .1f * job.params[C_ATT_PARAM].at(t) * in[C_INPUT].at(t);
+
+    osc.setFreq(pitch);
+    osc.setParams(a, b, c);
+    osc.process();
+
+    // (the odd channels have their waves swapped)
+    float wave1 = osc.getWave((ch % 2) ? 0 : 1);
+    float wave2 = osc.getWave((ch % 2) ? 1 : 0);
+    if (out[WAVE1_OUTPUT])
+      out[WAVE1_OUTPUT][n] = 5.f * wave1;
+    if (out[WAVE2_OUTPUT])
+      out[WAVE2_OUTPUT][n] = 5.f * wave2;
+  }
+}
+
+void render(const Job& job, int voice0, int voices, float* const* out) {
+  shared_ptr<RatFuncWavetable> wavetable;
+  if (job.options[ANTI_ALIASING_OPTION] == RatFuncOscillator::WAVETABLE)
+    wavetable = getWavetable();
+  for (int c = voice0; c < voice0 + voices; c++)
+    renderVoice(job, c, wavetable.get(), out + (c - voice0) * OUTPUTS_LEN);
+}
+
+} // namespace
+
+// The module doesn't apply its FM input (Funs::process() sets the frequency
+// again without it), so neither do we, and we leave out the FM amount knob.
+const ModuleInfo funsInfo = {
+  "Funs",
+  {
+    { "pitch", 4.f },
+    { "a", .5f },
+    { "b", .5f },
+    { "c", .5f },
+    { "aAtt", 0.f },
+    { "bAtt", 0.f },
+    { "cAtt", 0.f }
+  },
+  { "vOct", "a", "b", "c" },
+  { "wave1", "wave2" },
+  {
+    { "pitchQuant", 0. },
+    { "antiAliasing", 0. }
+  },
+  { "wave1", "wave2" },
+  true,
+  render
+};
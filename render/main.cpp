@@ -0,0 +1,236 @@
+// the offline renderer: renders Ad, Funs and Sjoegele with the classes in
+// src/dsp, without Rack, faster than real time, to WAV files
+// Build it with `make render` (see render/render.mk), then run
+//   build/render/render [-j threads] [-isa scalar|baseline|avx2|avx512]
+//     jobs.json ...
+//
+// A job file holds a job, or {"defaults": {...}, "jobs": [{...}, ...]}, where
+// the defaults are used for what the jobs don't give. A job is
+//   {
+//     "module": "Ad",            Ad, Funs or Sjoegele
+//     "output": "pad.wav",       relative to the working directory
+//     "duration": 10,            in seconds
+//     "sampleRate": 48000,
+//     "voices": 4,               the polyphony channels, 1 to 16
+//     "seed": 1,
+//     "params": { "partials": 5, "tilt": [[0, -.5], [10, .5]] },
+//     "options": { "stereoMode": 2, "unison": 3 },
+//     "inputs": { "vOct": 0, "cvBuffer": [[0, 0], [.5, 5], [1, 0]] },
+//     "voiceInputs": [ {}, { "vOct": .25 }, { "vOct": .5 } ],
+//     "outputs": [ "sumL", "sumR" ],
+//     "mixVoices": true
+//   }
+// Params are the knobs, inputs the CVs in volts, both either a number or
+// breakpoints [t, v] (interpolated linearly). The voiceInputs override the
+// inputs per voice. An input counts as patched if it is given for the job or
+// any voice. The options are the menu settings, with the names and values of
+// the module's patch JSON. The names of all of them are in the ModuleInfos in
+// render/ad.cpp, funs.cpp and sjoegele.cpp.
+//
+// The WAV file has 32-bit float samples in volts, a channel per output, or,
+// without mixVoices, per voice and output (voice by voice).
+//
+// The voices of Ad and Funs, and all the jobs, are rendered in parallel. The
+// output only depends on the job and its seed, not on the number of threads.
+// (It may depend on the CPU, through the DSP kernels; -isa pins those.)
+#include "Render.h"
+#include "dsp/DspKernels.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// a job being rendered, split up in tasks of one or more voices
+struct JobState {
+  Job job;
+  // a buffer per voice and output of the module, empty for the outputs we
+  // don't write (and until the voice is rendered)
+  vector<vector<float>> buffers;
+  atomic<int> tasksLeft{ 0 };
+  chrono::steady_clock::time_point start;
+  atomic<bool> started{ false };
+};
+
+struct Task {
+  JobState* state;
+  int voice0;
+  int voices;
+};
+
+mutex logMutex;
+atomic<bool> failed{ false };
+
+// Mix or interleave the voices and write the WAV file.
+void finish(JobState& s) {
+  const Job& job = s.job;
+  int outputs = job.module->outputs.size();
+  int voiceChannels = job.outputs.size();
+  int channels = (job.mixVoices) ? voiceChannels : job.voices * voiceChannels;
+  vector<float> interleaved((size_t)job.frames * channels, 0.f);
+  // (always in the same order, so that the sums don't depend on the timing)
+  for (int c = 0; c < job.voices; c++) {
+    for (int k = 0; k < voiceChannels; k++) {
+      const vector<float>& buffer = s.buffers[c * outputs + job.outputs[k]];
+      int channel = (job.mixVoices) ? k : c * voiceChannels + k;
+      for (int n = 0; n < job.frames; n++)
+        interleaved[(size_t)n * channels + channel] += buffer[n];
+    }
+  }
+  s.buffers.clear();
+
+  string error;
+  bool ok = writeWav(job.output, job.sampleRate, channels, job.frames,
+    interleaved.data(), error);
+  double seconds = chrono::duration<double>(
+    chrono::steady_clock::now() - s.start).count();
+  lock_guard<mutex> lock(logMutex);
+  if (ok) {
+    double duration = (double)job.frames / job.sampleRate;
+    fprintf(stderr, "%s: %.2f s of %s in %.2f s (%.0fx real time)\n",
+      job.output.c_str(), duration, job.module->name.c_str(), seconds,
+      duration / seconds);
+  } else {
+    fprintf(stderr, "%s\n", error.c_str());
+    failed.store(true);
+  }
+}
+
+void run(Task& task) {
+  JobState& s = *task.state;
+  if (!s.started.exchange(true))
+    s.start = chrono::steady_clock::now();
+  // (The buffers are only allocated now, so that the jobs which wait for
+  // their turn don't take up memory.)
+  int outputs = s.job.module->outputs.size();
+  vector<float*> out(task.voices * outputs, nullptr);
+  for (int c = task.voice0; c < task.voice0 + task.voices; c++) {
+    for (int o : s.job.outputs) {
+      vector<float>& buffer = s.buffers[c * outputs + o];
+      buffer.resize(s.job.frames);
+      out[(c - task.voice0) * outputs + o] = buffer.data();
+    }
+  }
+  s.job.module->render(s.job, task.voice0, task.voices, out.data());
+  // The last task of a job writes it.
+  if (s.tasksLeft.fetch_sub(1) == 1)
+    finish(s);
+}
+
+bool readJobs(const char* path, vector<unique_ptr<JobState>>& jobs) {
+  ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "%s: can't open\n", path);
+    return false;
+  }
+  stringstream text;
+  text << file.rdbuf();
+  Json json;
+  string error;
+  if (!Json::parse(text.str(), json, error)) {
+    fprintf(stderr, "%s: %s\n", path, error.c_str());
+    return false;
+  }
+
+  const Json* defaults = json.get("defaults");
+  const Json* jobsJ = json.get("jobs");
+  vector<const Json*> list;
+  if (jobsJ) {
+    for (const Json& j : jobsJ->array)
+      list.push_back(&j);
+  } else
+    list.push_back(&json);
+  for (size_t i = 0; i < list.size(); i++) {
+    unique_ptr<JobState> s(new JobState);
+    if (!s->job.fromJson(*list[i], defaults, error)) {
+      fprintf(stderr, "%s: job %d: %s\n", path, (int)i + 1, error.c_str());
+      return false;
+    }
+    jobs.push_back(move(s));
+  }
+  return true;
+}
+
+int usage() {
+  fprintf(stderr, "usage: render [-j threads] "
+    "[-isa scalar|baseline|avx2|avx512] jobs.json ...\n");
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int threads = thread::hardware_concurrency();
+  DspKernels::Isa isa = DspKernels::AVX512;
+  bool isaGiven = false;
+  vector<const char*> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+      threads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-isa") == 0 && i + 1 < argc) {
+      const char* names[] = { "scalar", "baseline", "avx2", "avx512" };
+      i++;
+      int k = 0;
+      while (k < DspKernels::ISAS_LEN && strcmp(argv[i], names[k]) != 0)
+        k++;
+      if (k == DspKernels::ISAS_LEN)
+        return usage();
+      isa = (DspKernels::Isa)k;
+      isaGiven = true;
+    } else if (argv[i][0] == '-')
+      return usage();
+    else
+      files.push_back(argv[i]);
+  }
+  if (files.empty())
+    return usage();
+  threads = max(threads, 1);
+
+  // like at plugin init (falling back on a lower variant if need be)
+  DspKernels::init(isa);
+  if (isaGiven && DspKernels::getIsa() != isa)
+    fprintf(stderr, "DSP kernels: %s\n",
+      DspKernels::getName(DspKernels::getIsa()));
+
+  vector<unique_ptr<JobState>> jobs;
+  for (const char* file : files) {
+    if (!readJobs(file, jobs))
+      return 1;
+  }
+
+  // The voices of a job get a task each if they're independent, else the
+  // job is one task.
+  vector<Task> tasks;
+  for (unique_ptr<JobState>& s : jobs) {
+    const Job& job = s->job;
+    s->buffers.resize(job.voices * job.module->outputs.size());
+    int step = (job.module->independentVoices) ? 1 : job.voices;
+    for (int c = 0; c < job.voices; c += step) {
+      tasks.push_back({ s.get(), c, step });
+      s->tasksLeft++;
+    }
+  }
+
+  // Each thread takes the next task until there are none left.
+  atomic<size_t> next{ 0 };
+  vector<thread> pool;
+  for (int i = 0; i < min(threads, (int)tasks.size()); i++) {
+    pool.push_back(thread([&]() {
+      for (size_t t = next++; t < tasks.size(); t = next++)
+        run(tasks[t]);
+    }));
+  }
+  for (thread& t : pool)
+    t.join();
+
+  return (failed.load()) ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+# `make render` builds the offline renderer, build/render/render, from
+# render/ and src/dsp, without the Rack SDK. See render/main.cpp for how to
+# run it and the format of the jobs.
+
+# the optimization flags Rack compiles plugins with (on x64)
+RENDER_FLAGS ?= -O3 -funsafe-math-optimizations -march=nehalem
+RENDER_CXXFLAGS = -std=c++11 $(RENDER_FLAGS) -Isrc
+RENDER_SOURCES = $(wildcard render/*.cpp) $(wildcard src/dsp/*.cpp)
+RENDER_OBJECTS = $(patsubst %.cpp,build/render/obj/%.o,$(RENDER_SOURCES))
+RENDER_TARGET = build/render/render
+
+# the variants of the DSP kernels, like in the Makefile
+build/render/obj/src/dsp/DspKernelsScalar.o: RENDER_CXXFLAGS += -fno-tree-vectorize
+ifneq ($(findstring x86_64,$(shell $(CXX) -dumpmachine)),)
+build/render/obj/src/dsp/DspKernelsAvx2.o: RENDER_CXXFLAGS += -mavx2 -mfma
+build/render/obj/src/dsp/DspKernelsAvx512.o: RENDER_CXXFLAGS += -mavx512f -mavx2 -mfma
+endif
+
+.PHONY: render
+
+render: $(RENDER_TARGET)
+
+$(RENDER_TARGET): $(RENDER_OBJECTS)
+	@echo "LD $@"
+	@$(CXX) $(RENDER_CXXFLAGS) $^ -o $@ -pthread
+
+build/render/obj/%.o: %.cpp $(wildcard render/*.h) $(wildcard src/dsp/*.h)
+	@mkdir -p $(@D)
+	@echo "CXX $<"
+	@$(CXX) $(RENDER_CXXFLAGS) -c $< -o $@
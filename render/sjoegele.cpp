@@ -0,0 +1,216 @@
+// Sjoegele, all voices at once, like Sjoegele::process() does it
+// (The voices share the number of substeps of the pendulum bank, so they
+// can't be rendered separately.)
+#include "Render.h"
+#include "dsp/DoublePendulumBank.h"
+#include "dsp/ChainPendulumBank.h"
+#include "dsp/FastMath.h"
+#include <memory>
+
+using namespace std;
+
+namespace {
+
+enum ParamId {
+  L_PARAM,
+  G_PARAM,
+  FRICTION_PARAM,
+  INIT_PARAM
+};
+enum InputId {
+  L_INPUT,
+  G_INPUT,
+  FRICTION_INPUT,
+  INIT_INPUT
+};
+enum OutputId {
+  X1_OUTPUT,
+  Y1_OUTPUT,
+  X2_OUTPUT,
+  Y2_OUTPUT,
+  TH1IS0_OUTPUT,
+  TH2IS0_OUTPUT,
+  OUTPUTS_LEN
+};
+enum OptionId {
+  X2Y2_RELATIVE_OPTION,
+  INTEGRATOR_OPTION,
+  SIM_RATE_OPTION,
+  LINKS_OPTION
+};
+
+struct State {
+  DoublePendulumBank pend;
+  ChainPendulumBank chain;
+  float pos[16][2][2 * ChainPendulumBank::MAX_LINKS] = {};
+};
+
+// Sjoegele::updatePositions()
+void updatePositions(State& s, int links, int c, bool jump) {
+  if (!jump) {
+    for (int i = 0; i < 2 * links; i++)
+      s.pos[c][0][i] = s.pos[c][1][i];
+  }
+  if (links == 2) {
+    s.pos[c][1][0] = s.pend.getX1(c);
+    s.pos[c][1][1] = s.pend.getY1(c);
+    s.pos[c][1][2] = s.pend.getX2Rel(c);
+    s.pos[c][1][3] = s.pend.getY2Rel(c);
+  } else {
+    for (int k = 0; k < links; k++) {
+      s.pos[c][1][2 * k] = s.chain.getX(c, k);
+      s.pos[c][1][2 * k + 1] = s.chain.getY(c, k);
+    }
+  }
+  if (jump) {
+    for (int i = 0; i < 2 * links; i++)
+      s.pos[c][0][i] = s.pos[c][1][i];
+  }
+}
+
+void render(const Job& job, int voice0, int voices, float* const* out) {
+  bool x2y2Relative = job.options[X2Y2_RELATIVE_OPTION] != 0.;
+  DoublePendulumBank::Integrator integrator =
+    (DoublePendulumBank::Integrator)(int)job.options[INTEGRATOR_OPTION];
+  int blockSize = 1 << (2 * (int)job.options[SIM_RATE_OPTION]);
+  int links = min(max((int)job.options[LINKS_OPTION], 2),
+    ChainPendulumBank::MAX_LINKS);
+
+  // (too big for the stack)
+  unique_ptr<State> state(new State);
+  State& s = *state;
+  s.pend.setSampleRate(job.sampleRate);
+  s.chain.setSampleRate(job.sampleRate);
+  s.pend.seed(job.voiceSeed(0));
+  s.chain.seed(job.voiceSeed(0));
+  s.chain.setLinks(links);
+
+  bool isInit[16] = {};
+  int blockCounter = 0;
+  for (int n = 0; n < job.frames; n++) {
+    double time = job.time(n);
+    float t = (float)(blockCounter + 1) / (float)blockSize;
+
+    for (int c = 0; c < voices; c++) {
+      const vector<Curve>& in = job.inputs[voice0 + c];
+      // (All the pendulums start on the first sample.)
+      bool initSignal = n == 0 || job.params[INIT_PARAM].at(time) > 0.f
+        || in[INIT_INPUT].at(time) > 2.5f;
+      if (initSignal && !isInit[c]) {
+        // Sjoegele::start()
+        float l = job.params[L_PARAM].at(time) + .4f * in[L_INPUT].at(time);
+        float g = job.params[G_PARAM].at(time) + 1.2f * in[G_INPUT].at(time);
+        l = FastMath::pow10<FastMath::MEDIUM>(l);
+        g = 9.8f * FastMath::exp2(g);
+        if (links == 2) {
+          s.pend.setLength(c, l);
+          s.pend.setGravity(c, g);
+          s.pend.init(c);
+        } else {
+          s.chain.setLength(c, l);
+          s.chain.setGravity(c, g);
+          s.chain.init(c);
+        }
+        updatePositions(s, links, c, true);
+        isInit[c] = true;
+      } else if (!initSignal)
+        isInit[c] = false;
+
+      if (blockCounter == 0) {
+        float cof = job.params[FRICTION_PARAM].at(time)
+          + .1f * in[FRICTION_INPUT].at(time);
+        cof = FastMath::pow10<FastMath::MEDIUM>(8.f * cof) - 1.f;
+        if (links == 2)
+          s.pend.setCOF(c, cof);
+        else
+          s.chain.setCOF(c, cof);
+      }
+    }
+
+    if (blockCounter == 0) {
+      if (links == 2) {
+        s.pend.setChannels(voices);
+        s.pend.setIntegrator(integrator);
+        s.pend.process(blockSize / (float)job.sampleRate);
+      } else {
+        s.chain.setChannels(voices);
+        s.chain.setIntegrator(integrator);
+        s.chain.process(blockSize / (float)job.sampleRate);
+      }
+      for (int c = 0; c < voices; c++)
+        updatePositions(s, links, c, false);
+    }
+
+    for (int c = 0; c < voices; c++) {
+      float p[2 * ChainPendulumBank::MAX_LINKS];
+      for (int i = 0; i < 2 * links; i++)
+        p[i] = s.pos[c][0][i] + t * (s.pos[c][1][i] - s.pos[c][0][i]);
+
+      // For a chain, x1 and y1 are the end of the first link (the module
+      // has a channel for each link of the first voice there).
+      float v[OUTPUTS_LEN];
+      if (links == 2) {
+        v[X1_OUTPUT] = 5.f * p[0];
+        v[Y1_OUTPUT] = 5.f * (p[1] + 1.f);
+        if (x2y2Relative) {
+          v[X2_OUTPUT] = 5.f * p[2];
+          v[Y2_OUTPUT] = 5.f * (p[3] + 1.f);
+        } else {
+          v[X2_OUTPUT] = 2.5f * (p[0] + p[2]);
+          v[Y2_OUTPUT] = 2.5f * (p[1] + p[3] + 2.f);
+        }
+        v[TH1IS0_OUTPUT] = (s.pend.th1Is0(c)) ? 5.f : 0.f;
+        v[TH2IS0_OUTPUT] = (s.pend.th2Is0(c)) ? 5.f : 0.f;
+      } else {
+        float scale = 5.f / links;
+        float x = 0.f;
+        float y = 0.f;
+        for (int k = 0; k < links; k++) {
+          x += p[2 * k];
+          y += p[2 * k + 1];
+        }
+        v[X1_OUTPUT] = scale * p[0];
+        v[Y1_OUTPUT] = scale * (p[1] + links);
+        if (x2y2Relative) {
+          v[X2_OUTPUT] = 5.f * p[2 * links - 2];
+          v[Y2_OUTPUT] = 5.f * (p[2 * links - 1] + 1.f);
+        } else {
+          v[X2_OUTPUT] = scale * x;
+          v[Y2_OUTPUT] = scale * (y + links);
+        }
+        v[TH1IS0_OUTPUT] = (s.chain.thIs0(c, 0)) ? 5.f : 0.f;
+        v[TH2IS0_OUTPUT] = (s.chain.thIs0(c, links - 1)) ? 5.f : 0.f;
+      }
+      for (int o = 0; o < OUTPUTS_LEN; o++) {
+        if (out[c * OUTPUTS_LEN + o])
+          out[c * OUTPUTS_LEN + o][n] = v[o];
+      }
+    }
+
+    blockCounter++;
+    blockCounter %= blockSize;
+  }
+}
+
+} // namespace
+
+const ModuleInfo sjoegeleInfo = {
+  "Sjoegele",
+  {
+    { "length", 0.f },
+    { "gravity", 0.f },
+    { "friction", 0.f },
+    { "start", 0.f }
+  },
+  { "length", "gravity", "friction", "start" },
+  { "x1", "y1", "x2", "y2", "th1Is0", "th2Is0" },
+  {
+    { "x2y2Relative", 0. },
+    { "integrator", 1. },
+    { "simRate", 2. },
+    { "links", 2. }
+  },
+  { "x2", "y2" },
+  false,
+  render
+};
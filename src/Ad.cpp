@@ -49,22 +49,32 @@ Ad::Ad() {
 	configOutput(SUM_R_OUTPUT, "sum right");
 	configOutput(FUND_OUTPUT, "fundamental");
 
-	blockSize = min(64, (int)(APP->engine->getSampleRate() / 750.f));
-	blockCounter = rand() % blockSize;
-
 	for (int c = 0; c < 16; c++) {
-		buf[c].init(
-			4.f * APP->engine->getSampleRate() / (float)blockSize,
-			128,
-			&cvBufferMode);
-		spec[c].init(128, &buf[c], 2, partialChan[c % 2]);
+		// (applyControlRate() sets the size)
+		buf[c].init(0, 128, &cvBufferMode, INT_MAX, getMaxCvBufferSize());
+		spec[c].init(128, &buf[c], 2, Spectrum::PARTIAL_CHAN[c % 2]);
+		workerSpec[c].init(128, &buf[c], 2, Spectrum::PARTIAL_CHAN[c % 2]);
 		osc[c].init(APP->engine->getSampleRate(), &spec[c]);
-		fundOsc[c].setSampleRate(APP->engine->getSampleRate());
+		uni[c].init(APP->engine->getSampleRate(), &spec[c]);
 	}
+	fundOsc.setSampleRate(APP->engine->getSampleRate());
+	applyControlRate();
+	processKnobs();
+
+	getLeftExpander().producerMessage = &busMessages[0];
+	getLeftExpander().consumerMessage = &busMessages[1];
 
 	reset(true);
 }
 
+Ad::~Ad() {
+	if (worker.joinable()) {
+		workerRunning.store(false);
+		notifyWorker();
+		worker.join();
+	}
+}
+
 json_t* Ad::dataToJson() {
 	json_t* rootJ = json_object();
 	json_object_set_new(rootJ, "pitchQuant",
@@ -77,6 +87,18 @@ json_t* Ad::dataToJson() {
 		json_integer(cvBufferMode));
 	json_object_set_new(rootJ, "emptyOnReset",
 		json_boolean(emptyOnReset));
+	json_object_set_new(rootJ, "displayRate",
+		json_integer(displayRate));
+	json_object_set_new(rootJ, "controlThread",
+		json_integer(controlThread));
+	json_object_set_new(rootJ, "unison",
+		json_integer(unison));
+	json_object_set_new(rootJ, "unisonDetune",
+		json_real(unisonDetune));
+	json_object_set_new(rootJ, "controlRate",
+		json_integer(controlRate));
+	json_object_set_new(rootJ, "followLeft",
+		json_boolean(followLeft));
 	return rootJ;
 }
 
@@ -96,6 +118,74 @@ void Ad::dataFromJson(json_t* rootJ) {
 	json_t* emptyOnResetJ = json_object_get(rootJ, "emptyOnReset");
 	if (emptyOnResetJ)
 		emptyOnReset = json_boolean_value(emptyOnResetJ);
+	json_t* displayRateJ = json_object_get(rootJ, "displayRate");
+	if (displayRateJ)
+		displayRate = (DisplayRate)json_integer_value(displayRateJ);
+	json_t* controlThreadJ = json_object_get(rootJ, "controlThread");
+	if (controlThreadJ)
+		setControlThread((ControlThread)json_integer_value(controlThreadJ));
+	json_t* unisonJ = json_object_get(rootJ, "unison");
+	if (unisonJ)
+		unison = json_integer_value(unisonJ);
+	json_t* unisonDetuneJ = json_object_get(rootJ, "unisonDetune");
+	if (unisonDetuneJ)
+		unisonDetune = json_number_value(unisonDetuneJ);
+	json_t* controlRateJ = json_object_get(rootJ, "controlRate");
+	if (controlRateJ)
+		controlRate = (ControlRate)json_integer_value(controlRateJ);
+	json_t* followLeftJ = json_object_get(rootJ, "followLeft");
+	if (followLeftJ)
+		followLeft = json_boolean_value(followLeftJ);
+}
+
+// not on the audio thread, since it may start the worker
+void Ad::setControlThread(ControlThread controlThread) {
+	if (controlThread == CONTROL_WORKER_THREAD && !worker.joinable()) {
+		workerRunning.store(true);
+		worker = thread(&Ad::work, this);
+	}
+	this->controlThread = controlThread;
+}
+
+void Ad::work() {
+	while (true) {
+		{
+			unique_lock<mutex> wakeLock(wakeMutex);
+			workerCv.wait(wakeLock, [this]() {
+				return workerPending.load() || !workerRunning.load();
+			});
+			if (!workerRunning.load())
+				return;
+			workerPending.store(false);
+		}
+
+		// Run the jobs until there are none left, or no room for the results.
+		// (The audio thread notifies us again with the next job it sends,
+		// or tries to send.)
+		lock_guard<mutex> lock(workerMutex);
+		ControlJob* job = controlJobs.front();
+		ControlResult* result = controlResults.back();
+		while (job && result) {
+			int c = job->c;
+			AdControl::runJob(*job, workerSpec[c], buf[c]);
+			result->c = c;
+			workerSpec[c].getResult(result->result);
+			controlJobs.pop();
+			controlResults.push();
+			job = controlJobs.front();
+			result = controlResults.back();
+		}
+	}
+}
+
+// Wake the worker up. (It only holds wakeMutex for a moment, so this hardly
+// waits, even on the audio thread.)
+void Ad::notifyWorker() {
+	workerPending.store(true);
+	{
+		lock_guard<mutex> wakeLock(wakeMutex);
+	}
+	workerCv.notify_one();
 }
 
 void Ad::onReset(const ResetEvent& e) {
@@ -110,31 +200,41 @@ void Ad::onRandomize(const RandomizeEvent& e) {
 
 void Ad::onSampleRateChange(const SampleRateChangeEvent& e) {
 	Module::onSampleRateChange(e);
-	blockSize = min(64, (int)(APP->engine->getSampleRate() / 750.f));
-	blockCounter = rand() % blockSize;
 
+	// Make sure the worker isn't busy with the CV buffers, and drop what it
+	// hasn't done yet. (The buffers keep their contents, resampled to the new
+	// rate, and the voices keep sounding.)
+	lock_guard<mutex> lock(workerMutex);
+	controlJobs.clear();
+	controlResults.clear();
+	for (int c = 0; c < 16; c++)
+		jobsInFlight[c] = 0;
+
+	fundOsc.setSampleRate(APP->engine->getSampleRate());
 	for (int c = 0; c < 16; c++) {
 		osc[c].setSampleRate(APP->engine->getSampleRate());
-		fundOsc[c].setSampleRate(APP->engine->getSampleRate());
-		spec[c].setSmoothCoeff(1.f / (float)blockSize);
-		// 4 seconds buffer
-		buf[c].resize(
-			(int)(4.f * APP->engine->getSampleRate() / (float)blockSize));
+		uni[c].setSampleRate(APP->engine->getSampleRate());
 	}
-	reset(true);
+	applyControlRate();
+}
+
+void Ad::onExpanderChange(const ExpanderChangeEvent& e) {
+	Module* leftModule = getLeftExpander().module;
+	busLinked = leftModule && (leftModule->getModel() == modelAd
+		|| leftModule->getModel() == modelAdje);
+	Module* rightModule = getRightExpander().module;
+	busRight = (rightModule && rightModule->getModel() == modelAd) ?
+		rightModule : nullptr;
 }
 
 void Ad::reset(int c, bool set0) {
-	if (!isReset[c]) {
-		buf[c].randomize();
+	// (The CV buffer is reset with the next block's control work.)
+	if (voices[c].reset(set0)) {
 		osc[c].reset();
-		fundOsc[c].reset();
-		if (set0) {
-			buf[c].empty();
+		uni[c].reset();
+		fundOsc.reset(c);
+		if (set0)
 			spec[c].set0();
-		}
-		isReset[c] = true;
-		isRandomized[c] = true;
 		resetLight = 1.f;
 	}
 }
@@ -144,7 +244,121 @@ void Ad::reset(bool set0) {
 		reset(c, set0);
 }
 
+void Ad::getControlJob(int c, ControlJob& job) {
+	AdControl::Inputs in;
+	in.partials = params[PARTIALS_PARAM].getValue();
+	in.tilt = params[TILT_PARAM].getValue();
+	in.sieve = params[SIEVE_PARAM].getValue();
+	in.cvBufferDelay = params[CVBUFFER_DELAY_PARAM].getValue();
+	in.partialsAtt = params[PARTIALS_ATT_PARAM].getValue();
+	in.tiltAtt = params[TILT_ATT_PARAM].getValue();
+	in.sieveAtt = params[SIEVE_ATT_PARAM].getValue();
+	in.partialsCv = inputs[PARTIALS_INPUT].getPolyVoltage(c);
+	in.tiltCv = inputs[TILT_INPUT].getPolyVoltage(c);
+	in.sieveCv = inputs[SIEVE_INPUT].getPolyVoltage(c);
+	in.cvBufferDelayCv = inputs[CVBUFFER_DELAY_INPUT].getPolyVoltage(c);
+	in.cvBufferPatched = inputs[CVBUFFER_INPUT].isConnected();
+	in.cvBuffer = inputs[CVBUFFER_INPUT].getPolyVoltage(c);
+	in.clockPatched = inputs[CVBUFFER_CLOCK_INPUT].isConnected();
+	in.clock = inputs[CVBUFFER_CLOCK_INPUT].getPolyVoltage(c);
+
+	AdControl::getJob(in,
+		(outputs[SUM_R_OUTPUT].isConnected()) ? stereoMode : Spectrum::MONO,
+		job);
+	job.c = c;
+	voices[c].getPending(job);
+}
+
+void Ad::publishDisplay() {
+	Display& d = display.getBack();
+	d.channels = channels;
+	d.linked = linked;
+	for (int c = 0; c < channels; c++) {
+		d.freq[c] = osc[c].getFreq() * APP->engine->getSampleTime();
+		d.stretch[c] = osc[c].getStretch();
+		d.lowest[c] = spec[c].getLowest();
+		d.highest[c] = spec[c].getHighest();
+		d.stereo[c] = spec[c].getStereoMode() != Spectrum::MONO;
+		for (int i = d.lowest[c] - 1; i < d.highest[c]; i++) {
+			d.amp[c][0][i] = spec[c].getAmp(i, 0);
+			if (d.stereo[c])
+				d.amp[c][1][i] = spec[c].getAmp(i, 1);
+		}
+	}
+	display.publish();
+}
+
+// the block size and what depends on it
+// (Not while the worker is busy with the CV buffers.)
+void Ad::applyControlRate() {
+	appliedControlRate = controlRate;
+	blockSize = getBlockSize(controlRate, APP->engine->getSampleRate());
+	blockCounter = rand() % blockSize;
+	setBlockPhases();
+	for (int c = 0; c < 16; c++) {
+		spec[c].setSmoothCoeff(1.f / (float)blockSize);
+		// 4 seconds buffer
+		buf[c].resize(getCvBufferSize(blockSize, APP->engine->getSampleRate()));
+	}
+}
+
+void Ad::setBlockPhases() {
+	for (int c = 0; c < 16; c++)
+		blockPhase[c] = AdControl::getBlockPhase(c, blockSize);
+}
+
+void Ad::processKnobs() {
+	pitchKnob = params[PITCH_PARAM].getValue();
+	// Quantize the pitch knob.
+	if (pitchQuant == OCTAVES)
+		pitchKnob = round(pitchKnob);
+	else if (pitchQuant == SEMITONES)
+		pitchKnob = round(12.f * pitchKnob) / 12.f;
+
+	stretchKnob = params[STRETCH_PARAM].getValue();
+	stretchAtt = .4f * params[STRETCH_ATT_PARAM].getValue();
+
+	// exponential mapping for the FM amount
+	fmAmt = FastMath::exp2<FastMath::MEDIUM>(
+		5.f * params[FMAMT_PARAM].getValue()) - 1.f;
+
+	// the unison options (from the menu), which seldom change
+	if (unison != uni[0].getStacks() || unisonDetune != uni[0].getDetune()) {
+		for (int c = 0; c < 16; c++)
+			uni[c].setStacks(unison, unisonDetune);
+	}
+}
+
 void Ad::process(const ProcessArgs& args) {
+	// the spectrum bus (see SpectrumBusMessage): what we get from the left,
+	// if anything, and what we send to the right
+	SpectrumBusMessage* busIn = (followLeft && busLinked) ?
+		(SpectrumBusMessage*)getLeftExpander().consumerMessage :
+		nullptr;
+	if (busIn && busIn->channels == 0)
+		busIn = nullptr;
+	linked = busIn != nullptr;
+	SpectrumBusMessage* busOut = (busRight) ?
+		(SpectrumBusMessage*)busRight->getLeftExpander().producerMessage :
+		nullptr;
+	if (busOut) {
+		// We pass on what we get, even if we don't play.
+		busOut->channels = (busIn) ? busIn->channels : 0;
+		for (int k = 0; k < 16; k++) {
+			busOut->fresh[k] = busIn && k < busIn->channels && busIn->fresh[k];
+			if (busOut->fresh[k])
+				busOut->results[k] = busIn->results[k];
+		}
+	}
+
+	// a new control rate from the menu (If the worker is busy with the CV
+	// buffers, we try again on the next sample.)
+	if (controlRate != appliedControlRate) {
+		unique_lock<mutex> lock(workerMutex, try_to_lock);
+		if (lock.owns_lock())
+			applyControlRate();
+	}
+
 	if (!(outputs[SUM_L_OUTPUT].isConnected() ||
 		outputs[SUM_R_OUTPUT].isConnected() ||
 		outputs[FUND_OUTPUT].isConnected()))
@@ -156,156 +370,166 @@ void Ad::process(const ProcessArgs& args) {
 		outputs[SUM_R_OUTPUT].setChannels(channels);
 		outputs[FUND_OUTPUT].setChannels(channels);
 
-		if (blockCounter == 0)
+		// We lead the voices to the right, unless we follow ourselves.
+		if (busOut && !busIn)
+			busOut->channels = channels;
+
+		// Take over the amplitudes the worker has finished (unless we've
+		// started following since).
+		for (ControlResult* r = controlResults.front(); r;
+			r = controlResults.front()) {
+			if (!busIn) {
+				spec[r->c].setResult(r->result);
+				if (busOut) {
+					busOut->results[r->c] = r->result;
+					busOut->fresh[r->c] = true;
+				}
+			}
+			jobsInFlight[r->c]--;
+			controlResults.pop();
+		}
+
+		if (blockCounter == 0) {
 			resetLight *= 1.f - (8 * blockSize) * APP->engine->getSampleTime();
+			processKnobs();
+			runSum = outputs[SUM_L_OUTPUT].isConnected()
+				|| outputs[SUM_R_OUTPUT].isConnected();
+			runFund = outputs[FUND_OUTPUT].isConnected();
+		}
+
+		// the per-channel control math, for all the channels in one pass
+		float pitch[16];
+		float pitchExp[16];
+		float freq[16];
+		float stretch[16];
+		PROFILE_START(profiler);
+		for (int c = 0; c < channels; c++) {
+			// Add the CV values to the knob values for pitch and stretch.
+			pitch[c] = pitchKnob + inputs[VPOCT_INPUT].getPolyVoltage(c);
+			stretch[c] = stretchKnob
+				+ stretchAtt * inputs[STRETCH_INPUT].getPolyVoltage(c);
+			freq[c] = inputs[FM_INPUT].getPolyVoltage(c);
+		}
+		FastMath::exp2(pitch, pitchExp, channels);
+		for (int c = 0; c < channels; c++) {
+			// Compute the pitch of the fundamental frequency.
+			pitch[c] = 16.35159783128741466737f * pitchExp[c];
+			// FM, only for the main additive oscillator,
+			// not for the fundamental sine oscillator
+			freq[c] = (1.f + .2f * freq[c] * fmAmt) * pitch[c];
+		}
+		PROFILE_LAP(profiler, CONTROL);
 
 		for (int c = 0; c < channels; c++) {
 			bool resetSignal = params[RESET_PARAM].getValue() > 0.f ||
 				inputs[RESET_INPUT].getPolyVoltage(c) > 2.5f;
-			if (resetSignal && !isReset[c]) {
+			if (resetSignal && !voices[c].isResetting()) {
 				reset(c, emptyOnReset);
 			} else {
 				if (!resetSignal)
-					isReset[c] = false;
-
-				if (blockCounter == 0) {
+					voices[c].release();
+
+				if (busIn) {
+					// Play the spectrum from the left.
+					int k = c % busIn->channels;
+					if (busIn->fresh[k])
+						spec[c].setResult(busIn->results[k]);
+				} else if (blockCounter == blockPhase[c]) {
 					// Do the stuff we want to do once every block:
-
-					// Get knob values.
-					float partials = params[PARTIALS_PARAM].getValue();
-					float tilt = params[TILT_PARAM].getValue();
-					float sieve = params[SIEVE_PARAM].getValue();
-					float cvBufferDelay = params[CVBUFFER_DELAY_PARAM].getValue();
-
-					// Add the CV values to the knob values for the rest of the
-					// parameters
-					partials += .7f * params[PARTIALS_ATT_PARAM].getValue()
-						* inputs[PARTIALS_INPUT].getPolyVoltage(c);
-					tilt += .2f * params[TILT_ATT_PARAM].getValue()
-						* inputs[TILT_INPUT].getPolyVoltage(c);
-					sieve += .2f * params[SIEVE_ATT_PARAM].getValue()
-						* inputs[SIEVE_INPUT].getPolyVoltage(c);
-					cvBufferDelay +=
-						.1f * inputs[CVBUFFER_DELAY_INPUT].getPolyVoltage(c);
-
-					// Map 'lowest' to 'tilt' and 'lowest'.
-					float lowest = 1.f;
-					if (tilt >= 0.f) {
-						// exponential mapping for lowest
-						lowest = exp2_taylor5(tilt * 6.f);
-						tilt = 0.f;
-					} else {
-						tilt = max(tilt, -1.f);
-						tilt = tilt / (1.f + tilt);
-					}
-
-					// exponential mapping for partials
-					partials = exp2_taylor5(partials);
-					float highest = lowest + partials;
-					buf[c].setLowestHighest(lowest, highest);
-					spec[c].setLowestHighest(lowest, highest);
-					spec[c].setTilt(tilt);
-
-					if (sieve > 0.f) {
-						spec[c].setKeepPrimes(true);
-						// Map sieve -> a*2^(b*sieve)+c, such that:
-						// 0->0, .4->1 and 1->5.001 (because prime[4]=11,
-						// and a .001 just to be on the safe side)
-						sieve = .876713f * exp2_taylor5(2.74508f * sieve) - 0.876713f;
-						sieve = clamp(sieve, 0.f, 5.f);
-					} else {
-						spec[c].setKeepPrimes(false);
-						// the same thing, but with the reversed order of the primes
-						// map sieve: 0->31, -.8->2, -1->.999 (because prime[30]=127)
-						sieve = 31.0238f * exp2_taylor5(4.92282f * sieve) - 0.0237689f;
-						sieve = clamp(sieve, 0.f, 31.f);
-					}
-					spec[c].setSieve(sieve);
-
-					if (inputs[CVBUFFER_INPUT].isConnected()) {
-						buf[c].setOn(true);
-						spec[c].setComb(0.f);
-
-						if (inputs[CVBUFFER_CLOCK_INPUT].isConnected()) {
-							buf[c].setClocked(true);
-							buf[c].setClockTrigger(
-								inputs[CVBUFFER_CLOCK_INPUT].getPolyVoltage(c) > 2.5f);
-						} else
-							buf[c].setClocked(false);
-
-						if (abs(cvBufferDelay) > .95f)
-							buf[c].setFrozen(true);
-						else {
-							buf[c].setFrozen(false);
-
-							cvBufferDelay /= .95f;
-							// exponential mapping
-							cvBufferDelay = (powf(10.f, cvBufferDelay) - 1.f) / 9.f;
-							buf[c].setDelayRel(cvBufferDelay);
-							buf[c].push(.1f * inputs[CVBUFFER_INPUT].getPolyVoltage(c));
+					PROFILE_SCOPE(profiler, CONTROL);
+					ControlJob job;
+					getControlJob(c, job);
+					bool done = false;
+					if (controlThread == CONTROL_WORKER_THREAD) {
+						done = controlJobs.push(job);
+						if (done)
+							jobsInFlight[c]++;
+						// (also if the queue is full, since the worker may be
+						// asleep with no room for the results)
+						notifyWorker();
+					} else if (jobsInFlight[c] == 0) {
+						AdControl::runJob(job, spec[c], buf[c]);
+						done = true;
+						if (busOut) {
+							spec[c].getResult(busOut->results[c]);
+							busOut->fresh[c] = true;
 						}
-						buf[c].process();
-					} else {
-						buf[c].setOn(false);
-						spec[c].setComb(cvBufferDelay);
 					}
+					// (If the worker is lagging, we try again next block.)
+					if (done)
+						voices[c].jobDone();
+				}
 
-					spec[c].setStereoMode((outputs[SUM_R_OUTPUT].isConnected()) ?
-						stereoMode :
-						Spectrum::MONO
-					);
-
-					spec[c].process();
+				osc[c].setStretch(stretch[c], stretchQuant);
+				osc[c].setFreq(freq[c]);
+				if (unison > 1) {
+					uni[c].setStretch(osc[c].getStretch());
+					uni[c].setFreq(freq[c]);
 				}
 
-				float stretch = params[STRETCH_PARAM].getValue();
-				stretch += .4f * params[STRETCH_ATT_PARAM].getValue()
-					* inputs[STRETCH_INPUT].getPolyVoltage(c);
-				osc[c].setStretch(stretch, stretchQuant);
-
-				float pitch = params[PITCH_PARAM].getValue();
-				// Quantize the pitch knob.
-				if (pitchQuant == OCTAVES)
-					pitch = round(pitch);
-				else if (pitchQuant == SEMITONES)
-					pitch = round(12.f * pitch) / 12.f;
-				// Add the CV values to the knob values for pitch, fm and stretch.
-				pitch += inputs[VPOCT_INPUT].getPolyVoltage(c);
-
-				// Compute the pitch of the fundamental frequency.
-				pitch = 16.35159783128741466737f * exp2f(pitch);
-
-				// FM, only for the main additive oscillator,
-				// not for the fundamental sine oscillator
-				// exponential mapping for the FM amount
-				float fm = inputs[FM_INPUT].getPolyVoltage(c) * .2f;
-				float fmAmt = exp2f(5.f * params[FMAMT_PARAM].getValue()) - 1.f;
-				osc[c].setFreq((1.f + fm * fmAmt) * pitch);
-
-				int fundMult = 1;
-				do
-					fundMult *= 2;
-				while (fundMult
-					<= abs(1.f + (spec[c].getLowest() - 1) * osc[c].getStretch()));
-				fundMult /= 2;
-				fundOsc[c].setFreq(fundMult * pitch);
+				fundOsc.setFreq(c, voices[c].getFundMult(spec[c].getLowest(),
+					osc[c].getStretch()) * pitch[c]);
 			}
 
-			if (spec[c].ampsAre0() && !isRandomized[c]) {
+			if (voices[c].checkSilence(spec[c].ampsAre0())) {
 				osc[c].reset();
-				buf[c].randomize();
-				isRandomized[c] = true;
+				uni[c].reset();
 				resetLight = 1.f;
-			} else if (!spec[c].ampsAre0())
-				isRandomized[c] = false;
+			}
 
-			spec[c].smoothen();
-			osc[c].process();
-			fundOsc[c].process();
+			// A voice with a silent spectrum sleeps: we skip the smoothing and the
+			// oscillator. When it wakes up, we catch up on its phases, as if it had
+			// been running all the time. The same goes for all the voices when
+			// only the fundamental output is patched.
+			if (runSum) {
+				PROFILE_SCOPE(profiler, SMOOTHING);
+				spec[c].smoothen();
+			}
+			if (!runSum || spec[c].isSilent()) {
+				int skip = voices[c].sleep(blockCounter == blockPhase[c]);
+				if (skip > 0) {
+					osc[c].skip(skip);
+					uni[c].skip(skip);
+				}
+				outputs[SUM_L_OUTPUT].setVoltage(0.f, c);
+				outputs[SUM_R_OUTPUT].setVoltage(0.f, c);
+				continue;
+			}
+			int skip = voices[c].wake();
+			if (skip > 0) {
+				osc[c].skip(skip);
+				uni[c].skip(skip);
+			}
+			PROFILE_SCOPE(profiler, SYNTHESIS);
+			if (unison > 1) {
+				uni[c].process();
+				outputs[SUM_L_OUTPUT].setVoltage(5.f * uni[c].getWave(0), c);
+				outputs[SUM_R_OUTPUT].setVoltage(5.f * uni[c].getWave(1), c);
+			} else {
+				osc[c].process();
+				outputs[SUM_L_OUTPUT].setVoltage(5.f * osc[c].getWave(0), c);
+				outputs[SUM_R_OUTPUT].setVoltage(5.f * osc[c].getWave(1), c);
+			}
+		}
 
-			outputs[SUM_L_OUTPUT].setVoltage(5.f * osc[c].getWave(0), c);
-			outputs[SUM_R_OUTPUT].setVoltage(5.f * osc[c].getWave(1), c);
-			outputs[FUND_OUTPUT].setVoltage(5.f * fundOsc[c].getWave(), c);
+		// all the fundamentals in one go, or, if they aren't patched, just
+		// keep track of their phases, like for the sleeping voices
+		if (runFund) {
+			PROFILE_SCOPE(profiler, SYNTHESIS);
+			if (fundSleepSamples > 0) {
+				fundOsc.skip(fundSleepSamples);
+				fundSleepSamples = 0;
+			}
+			fundOsc.setChannels(channels);
+			fundOsc.process();
+			for (int c = 0; c < channels; c++)
+				outputs[FUND_OUTPUT].setVoltage(5.f * fundOsc.getWave(c), c);
+		} else {
+			fundSleepSamples++;
+			if (blockCounter == 0) {
+				fundOsc.skip(fundSleepSamples);
+				fundSleepSamples = 0;
+			}
 		}
 
 		lights[RESET_LIGHT].setBrightness(resetLight);
@@ -313,6 +537,18 @@ void Ad::process(const ProcessArgs& args) {
 		blockCounter++;
 		blockCounter %= blockSize;
 	}
+
+	if (busOut)
+		busRight->getLeftExpander().requestMessageFlip();
+
+	displayCounter++;
+	if (displayCounter >= args.sampleRate / 60.f) {
+		PROFILE_SCOPE(profiler, OUTPUT);
+		publishDisplay();
+		displayCounter = 0;
+	}
+
+	PROFILE_END_SAMPLE(profiler);
 }
 
 Model* modelAd = createModel<Ad, AdWidget>("Ad");
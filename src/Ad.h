@@ -8,10 +8,19 @@
 #pragma once
 #include <iostream>
 #include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "rack.hpp"
 #include "vanTies.h"
 #include "dsp/AdditiveOscillator.h"
-#include "dsp/SineOscillator.h"
+#include "dsp/UnisonOscillator.h"
+#include "dsp/SineBank.h"
+#include "dsp/AdControl.h"
+#include "dsp/FastMath.h"
+#include "dsp/SpscQueue.h"
+#include "dsp/TripleBuffer.h"
+#include "dsp/Profiler.h"
 
 struct Ad : Module {
 	enum ParamId {
@@ -58,79 +67,199 @@ struct Ad : Module {
 		SEMITONES,
 		OCTAVES
 	};
+
+	// the maximum update rate of the spectrum display: 60 fps / 2^displayRate
+	enum DisplayRate {
+		DISPLAY_60FPS,
+		DISPLAY_30FPS,
+		DISPLAY_15FPS
+	};
+
+	// where the amplitudes of the partials are computed: inline on the audio
+	// thread, or on a background thread, one block later
+	enum ControlThread {
+		CONTROL_AUDIO_THREAD,
+		CONTROL_WORKER_THREAD
+	};
 	
 	Ad();
+	~Ad();
 
-	// Distribute the partials over the left and right channels, in such a way
-	// that for any value of the sieve parameter, the two channels are pretty much in
-	// balance. 
-	// For 128 oscillators, 1 we need 27 ints (leave out the fundamental)
-	int partialChan[2][127] = { {
-		1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-		1, 0, 1, 1, 0, 1, 0, 0, 0, 0,
-		0, 1, 1, 1, 1, 0, 1, 0, 0, 1,
-		1, 1, 0, 0, 1, 0, 1, 0, 1, 1,
-		1, 0, 0, 0, 0, 1, 0, 0, 1, 1,
-		1, 0, 1, 1, 1, 0, 1, 1, 0, 0,
-		0, 0, 0, 0, 0, 1, 0, 1, 1, 0,
-		0, 1, 1, 1, 1, 1, 1, 0, 0, 1,
-		0, 1, 0, 1, 1, 0, 0, 0, 1, 0,
-		0, 1, 0, 0, 0, 1, 1, 1, 0, 0,
-		0, 1, 1, 0, 1, 0, 1, 1, 0, 0,
-		1, 0, 1, 1, 1, 0, 0, 1, 1, 1,
-		1, 1, 0, 0, 0, 1, 1
-	},{
-		0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-		0, 1, 0, 0, 1, 0, 1, 1, 1, 1,
-		1, 0, 0, 0, 0, 1, 0, 1, 1, 0,
-		0, 0, 1, 1, 0, 1, 0, 1, 0, 0,
-		0, 1, 1, 1, 1, 0, 1, 1, 0, 0,
-		0, 1, 0, 0, 0, 1, 0, 0, 1, 1,
-		1, 1, 1, 1, 1, 0, 1, 0, 0, 1,
-		1, 0, 0, 0, 0, 0, 0, 1, 1, 0,
-		1, 0, 1, 0, 0, 1, 1, 1, 0, 1,
-		1, 0, 1, 1, 1, 0, 0, 0, 1, 1,
-		1, 0, 0, 1, 0, 1, 0, 0, 1, 1,
-		0, 1, 0, 0, 0, 1, 1, 0, 0, 0,
-		0, 0, 1, 1, 1, 0, 0
-	} };
-	
 	PitchQuant pitchQuant = CONTINUOUS;
 	AdditiveOscillator::StretchQuant stretchQuant = AdditiveOscillator::CONTINUOUS;
 	Spectrum::StereoMode stereoMode = Spectrum::SOFT_PAN;
 	CvBuffer::Mode cvBufferMode = CvBuffer::LOW_HIGH;
 	bool emptyOnReset = false;
+	DisplayRate displayRate = DISPLAY_60FPS;
+	ControlThread controlThread = CONTROL_AUDIO_THREAD;
+	// the number of detuned oscillators per voice, and their spread in cents
+	int unison = 1;
+	float unisonDetune = 20.f;
+
+	ControlRate controlRate = CONTROL_RATE_64;
+	// the control rate the block size is for (the menu sets controlRate, and
+	// process() catches up)
+	ControlRate appliedControlRate = CONTROL_RATE_64;
 
 	// A part of the code will be excecuted at a lower rate than the sample
 	int blockSize;
 	int blockCounter;
+	// The voices don't all do their block-rate work on the same sample, which
+	// would make that sample a lot more expensive than the others. Voice c
+	// does it when blockCounter == blockPhase[c].
+	int blockPhase[16] = {};
+
+	// the terms of the control math that only depend on the knobs, computed
+	// once per block
+	float pitchKnob = 0.f;
+	float stretchKnob = 0.f;
+	float stretchAtt = 0.f;
+	float fmAmt = 0.f;
 
 	int channels = 0;
-	bool isReset[16] = {};
-	bool isRandomized[16] = {};
+	// the resets, the sleeping and the fundamental of each voice
+	AdControl::Voice voices[16];
+	// We only run the kernels whose outputs are patched: the additive
+	// oscillators for the sum outputs (mono or stereo, following the
+	// spectrum), and the sine bank for the fundamental output. Set once per
+	// block.
+	bool runSum = true;
+	bool runFund = true;
+	int fundSleepSamples = 0;
 	float resetLight = 0.f;
 
 	CvBuffer buf[16];
 	Spectrum spec[16];
 	AdditiveOscillator osc[16];
-	SineOscillator fundOsc[16];
+	// used instead of osc[] when unison > 1
+	UnisonOscillator uni[16];
+	SineBank fundOsc;
+
+	// The spectrum bus: an Ad can play the spectra of the module directly to
+	// its left, an Adje or another Ad, instead of computing its own (if
+	// followLeft is set in the menu), and pass
+	// them on to the Ad to its right. So the first module of the row (the
+	// leader) computes the spectra for all of them. Each Ad owns the two
+	// buffers of the message from the left (Rack swaps them after every
+	// sample), and the module on the left writes into the producer one every
+	// sample, with the results of the spectra it computed or received in
+	// that sample.
+	struct SpectrumBusMessage {
+		// the number of spectra, 0 if the module on the left doesn't send
+		// any (e.g. because its outputs aren't patched); voice c plays
+		// spectrum c % channels
+		int channels = 0;
+		bool fresh[16] = {};
+		Spectrum::Result results[16];
+	};
+	SpectrumBusMessage busMessages[2];
+	bool followLeft = false;
+	// set on expander changes: whether the module to our left can send
+	// spectra
+	bool busLinked = false;
+	Module* busRight = nullptr;
+	// whether we play the spectra from the left at the moment
+	bool linked = false;
+
+	// what the spectrum widget draws, published by the audio thread at
+	// about 60 fps
+	struct Display {
+		int channels = 0;
+		// whether we play the spectra from the module to the left
+		bool linked = false;
+		// the frequency of the fundamental, relative to the sample rate
+		float freq[16] = {};
+		float stretch[16] = {};
+		int lowest[16] = {};
+		int highest[16] = {};
+		bool stereo[16] = {};
+		float amp[16][2][128] = {};
+	};
+	TripleBuffer<Display> display;
+	int displayCounter = 0;
+
+#ifdef VANTIES_PROFILE
+	// the cycle counts of process(), see the context menu
+	Profiler profiler;
+#endif
+
+	// everything the control work of a voice needs for one block
+	typedef AdControl::Job ControlJob;
+	struct ControlResult {
+		int c;
+		Spectrum::Result result;
+	};
+
+	// In the CONTROL_WORKER_THREAD mode, the audio thread sends the jobs to
+	// the worker, which runs them on buf[] and its own workerSpec[], and
+	// sends back the amplitudes. The worker only starts when this mode is
+	// first selected. From then on, only the worker touches buf[] (unless
+	// it's waiting, with workerMutex unlocked). It sleeps until
+	// notifyWorker() sets workerPending, so back in the audio thread mode it
+	// finishes the jobs it has and then stays asleep.
+	SpscQueue<ControlJob, 64> controlJobs;
+	SpscQueue<ControlResult, 64> controlResults;
+	Spectrum workerSpec[16];
+	// the number of jobs of a voice the worker hasn't sent back yet; when we
+	// switch back to the audio thread, we wait until this is 0
+	int jobsInFlight[16] = {};
+	std::thread worker;
+	std::atomic<bool> workerRunning{ false };
+	std::mutex workerMutex;
+	// The worker only holds wakeMutex to check workerPending and fall
+	// asleep, so that a notification can't get lost in between.
+	std::atomic<bool> workerPending{ false };
+	std::mutex wakeMutex;
+	std::condition_variable workerCv;
 
 	json_t* dataToJson() override;
 	void dataFromJson(json_t* rootJ) override;
 	void onReset(const ResetEvent& e) override;
 	void onRandomize(const RandomizeEvent& e) override;
 	void onSampleRateChange(const SampleRateChangeEvent& e) override;
+	void onExpanderChange(const ExpanderChangeEvent& e) override;
 	void reset(int c, bool set0);
 	void reset(bool set0);
+	void publishDisplay();
+	void applyControlRate();
+	void setBlockPhases();
+	void processKnobs();
+	void setControlThread(ControlThread controlThread);
+	void work();
+	void notifyWorker();
+	void getControlJob(int c, ControlJob& job);
 	void process(const ProcessArgs& args) override;
 };
 
-struct AdSpectrumWidget : Widget {
+struct AdSpectrumLinesWidget;
+
+// The spectrum is drawn in a framebuffer, which is only redrawn when the
+// spectral lines have moved noticeably. We show it in the light layer, so that
+// it stays visible when the room lights are dimmed.
+struct AdSpectrumWidget : FramebufferWidget {
 	Ad* module;
+	AdSpectrumLinesWidget* linesWidget;
+
+	// the spectral lines, as their x-values and the y-values of their tops,
+	// one list per color: left, right, and where left and right overlap
+	std::vector<Vec> lines[3];
+	double lastUpdate = 0.;
 
+	AdSpectrumWidget();
+	bool updateLines();
+	void step() override;
+	void draw(const DrawArgs& args) override;
 	void drawLayer(const DrawArgs& args, int layer) override;
 };
 
+// draws the lines of an AdSpectrumWidget into its framebuffer,
+// one path per color
+struct AdSpectrumLinesWidget : Widget {
+	AdSpectrumWidget* spectrum;
+
+	void draw(const DrawArgs& args) override;
+};
+
 struct AdWidget : ModuleWidget {
 	AdWidget(Ad* module);
 
@@ -3,84 +3,137 @@
 using namespace std;
 using namespace dsp;
 
+// Map the amplitudes logaritmically
+// to corresponding y-values: 1 -> 1, 2^-9 -> 1/16 .
+static float ampToY(float amp, float height) {
+	amp = abs(amp);
+	return (amp > .00128858194411415455f) ?
+		height * (.10416666666666666667f * log2f(amp) + 1.f) :
+		0.f;
+}
+
+AdSpectrumWidget::AdSpectrumWidget() {
+	linesWidget = new AdSpectrumLinesWidget;
+	linesWidget->spectrum = this;
+	addChild(linesWidget);
+}
+
+// Compute the spectral lines from the latest snapshot, returns whether they
+// moved by more than half a pixel.
+bool AdSpectrumWidget::updateLines() {
+	const Ad::Display& d = module->display.getFront();
+	std::vector<Vec> newLines[3];
+	for (int k = 0; k < 3; k++)
+		newLines[k].reserve(lines[k].size());
+
+	for (int c = 0; c < d.channels; c++) {
+		// Get the x-value for the fundamental:
+		// 0Hz is on the very left, the Nyquist freqency on the right.
+		float x1 = 2.f * abs(d.freq[c] * box.size.x);
+
+		for (int i = d.highest[c] - 1; i >= d.lowest[c] - 1; i--) {
+			float x = abs(1.f + i * d.stretch[c]) * x1;
+			if (!(x > 0.f && x < box.size.x))
+				continue;
+
+			if (d.stereo[c]) {
+				float yL = ampToY(d.amp[c][0][i], box.size.y);
+				float yR = ampToY(d.amp[c][1][i], box.size.y);
+				// the longer line in its own color,
+				// the shorter one in the overlap color
+				if (yL > yR)
+					newLines[0].push_back(Vec(x, box.size.y - yL));
+				else if (yR > 0.f)
+					newLines[1].push_back(Vec(x, box.size.y - yR));
+				if (min(yL, yR) > 0.f)
+					newLines[2].push_back(Vec(x, box.size.y - min(yL, yR)));
+			} else {
+				float y = ampToY(d.amp[c][0][i], box.size.y);
+				if (y > 0.f)
+					newLines[0].push_back(Vec(x, box.size.y - y));
+			}
+		}
+	}
+
+	bool changed = false;
+	for (int k = 0; k < 3 && !changed; k++) {
+		if (newLines[k].size() != lines[k].size()) {
+			changed = true;
+			break;
+		}
+		for (size_t j = 0; j < lines[k].size(); j++) {
+			if (abs(newLines[k][j].x - lines[k][j].x) > .5f
+				|| abs(newLines[k][j].y - lines[k][j].y) > .5f) {
+				changed = true;
+				break;
+			}
+		}
+	}
+	if (changed) {
+		for (int k = 0; k < 3; k++)
+			lines[k].swap(newLines[k]);
+	}
+	return changed;
+}
+
+void AdSpectrumWidget::step() {
+	if (module) {
+		double time = system::getTime();
+		float minTime = (float)(1 << module->displayRate) / 60.f;
+		if (time - lastUpdate >= minTime && module->display.update()) {
+			lastUpdate = time;
+			if (updateLines())
+				setDirty();
+		}
+	}
+	linesWidget->box.size = box.size;
+	FramebufferWidget::step();
+}
+
+void AdSpectrumWidget::draw(const DrawArgs& args) {
+	// Nothing here, we draw in the light layer.
+}
+
 void AdSpectrumWidget::drawLayer(const DrawArgs& args, int layer) {
 	if (!module)
 		return;
 
 	if (layer == 1) {
-		for (int c = 0; c < module->channels; c++) {
-			// Get the x-value for the fundamental:
-			// 0Hz is on the very left, the Nyquist freqency on the right.
-			float x1 = 2.f *
-				abs(module->osc[c].getFreq() * box.size.x *
-					APP->engine->getSampleTime());
-
-			nvgStrokeWidth(args.vg, 1.5f);
-
-			if (module->spec[c].getStereoMode() != Spectrum::MONO) {
-				for (int i = module->spec[c].getHighest() - 1;
-					i >= module->spec[c].getLowest() - 1; i--) {
-					float x = abs(1.f + i * module->osc[c].getStretch()) * x1;
-					if (x > 0.f && x < box.size.x) {
-						float yL = abs(module->spec[c].getAmp(i, 0));
-						float yR = abs(module->spec[c].getAmp(i, 1));
-						// Map the amplitudes logaritmically
-						// to corresponding y-values: 1 -> 1, 2^-9 -> 1/16 .
-						yL = (yL > .00128858194411415455f) ?
-							box.size.y * (.10416666666666666667f * log2f(yL) + 1.f) :
-							0.f;
-						yR = (yR > .00128858194411415455f) ?
-							box.size.y * (.10416666666666666667f * log2f(yR) + 1.f) :
-							0.f;
-						// Draw the spectral lines.
-						if (yL > yR) {
-							nvgStrokeColor(args.vg, nvgRGBf(1.f, 1.f, .75f));
-							nvgBeginPath(args.vg);
-							nvgMoveTo(args.vg, x, box.size.y);
-							nvgLineTo(args.vg, x, box.size.y - yL);
-							nvgStroke(args.vg);
-							nvgStrokeColor(args.vg, nvgRGBf(1.f, .75f, .625f));
-							nvgBeginPath(args.vg);
-							nvgMoveTo(args.vg, x, box.size.y);
-							nvgLineTo(args.vg, x, box.size.y - yR);
-						} else {
-							nvgStrokeColor(args.vg, nvgRGBf(1.f, .5f, .5f));
-							nvgBeginPath(args.vg);
-							nvgMoveTo(args.vg, x, box.size.y);
-							nvgLineTo(args.vg, x, box.size.y - yR);
-							nvgStroke(args.vg);
-							nvgStrokeColor(args.vg, nvgRGBf(1.f, .75f, .625f));
-							nvgBeginPath(args.vg);
-							nvgMoveTo(args.vg, x, box.size.y);
-							nvgLineTo(args.vg, x, box.size.y - yL);
-						}
-						nvgStroke(args.vg);
-					}
-				}
-			} else {
-				nvgStrokeColor(args.vg, nvgRGBf(1.f, 1.f, .75f));
-				for (int i = module->spec[c].getHighest() - 1;
-					i >= module->spec[c].getLowest() - 1; i--) {
-					float x = abs(1.f + i * module->osc[c].getStretch()) * x1;
-					if (x > 0.f && x < box.size.x) {
-						float y = abs(module->spec[c].getAmp(i));
-						// Map the amplitudes logaritmically
-						// to corresponding y-values: 1 -> 1, 2^-9 -> 1/16 .
-						y = (y > .00128858194411415455f) ?
-							box.size.y * (.10416666666666666667f * log2f(y) + 1.f) :
-							0.f;
-						// Draw the spectral lines.
-						nvgBeginPath(args.vg);
-						nvgMoveTo(args.vg, x, box.size.y);
-						nvgLineTo(args.vg, x, box.size.y - y);
-						nvgStroke(args.vg);
-					}
-				}
-			}
+		FramebufferWidget::draw(args);
+
+		// like Bufke, when we play the spectra from the module to the left
+		if (module->display.getFront().linked) {
+			nvgBeginPath(args.vg);
+			nvgFillColor(args.vg, nvgRGBf(1.f, .5f, .5f));
+			nvgFontSize(args.vg, 9.f);
+			nvgText(args.vg, 1.5f, 9.f, "\u21C4", NULL);
+			nvgFill(args.vg);
+			nvgClosePath(args.vg);
 		}
 	}
 
-	Widget::drawLayer(args, layer);
+	FramebufferWidget::drawLayer(args, layer);
+}
+
+void AdSpectrumLinesWidget::draw(const DrawArgs& args) {
+	NVGcolor color[3] = {
+		nvgRGBf(1.f, 1.f, .75f),
+		nvgRGBf(1.f, .5f, .5f),
+		nvgRGBf(1.f, .75f, .625f)
+	};
+
+	nvgStrokeWidth(args.vg, 1.5f);
+	for (int k = 0; k < 3; k++) {
+		if (spectrum->lines[k].empty())
+			continue;
+		nvgStrokeColor(args.vg, color[k]);
+		nvgBeginPath(args.vg);
+		for (const Vec& line : spectrum->lines[k]) {
+			nvgMoveTo(args.vg, line.x, box.size.y);
+			nvgLineTo(args.vg, line.x, line.y);
+		}
+		nvgStroke(args.vg);
+	}
 }
 
 AdWidget::AdWidget(Ad* module) {
@@ -191,4 +244,62 @@ void AdWidget::appendContextMenu(Menu* menu) {
 	menu->addChild(createBoolPtrMenuItem(
 		"Empty buffer on reset", "",
 		&module->emptyOnReset));
+
+	menu->addChild(createBoolPtrMenuItem(
+		"Play spectrum of left module", "",
+		&module->followLeft));
+
+	menu->addChild(createIndexPtrSubmenuItem(
+		"Spectrum display rate",
+		{ "60 fps",
+			"30 fps",
+			"15 fps" },
+		&module->displayRate));
+
+	menu->addChild(createIndexSubmenuItem(
+		"Unison",
+		{ "Off",
+			"2 oscillators",
+			"3 oscillators",
+			"4 oscillators",
+			"5 oscillators",
+			"6 oscillators",
+			"7 oscillators",
+			"8 oscillators" },
+		[=]() { return module->unison - 1; },
+		[=](int i) { module->unison = i + 1; }));
+
+	static const float UNISON_DETUNE[] = { 5.f, 10.f, 20.f, 40.f };
+	menu->addChild(createIndexSubmenuItem(
+		"Unison detune",
+		{ "5 cents",
+			"10 cents",
+			"20 cents",
+			"40 cents" },
+		[=]() {
+			for (int i = 0; i < 4; i++) {
+				if (module->unisonDetune <= UNISON_DETUNE[i])
+					return i;
+			}
+			return 3;
+		},
+		[=](int i) { module->unisonDetune = UNISON_DETUNE[i]; }));
+
+	menu->addChild(createIndexSubmenuItem(
+		"Control processing",
+		{ "Audio thread",
+			"Background thread" },
+		[=]() { return module->controlThread; },
+		[=](int i) { module->setControlThread((Ad::ControlThread)i); }));
+
+	menu->addChild(createControlRateMenuItem(&module->controlRate));
+
+	// which variant of the DSP kernels runs on this CPU
+	menu->addChild(new MenuSeparator);
+	menu->addChild(createMenuLabel(std::string("DSP kernels: ")
+		+ DspKernels::getName(DspKernels::getIsa())));
+
+#ifdef VANTIES_PROFILE
+	appendProfilerMenu(menu, &module->profiler);
+#endif
 }
@@ -1,4 +1,5 @@
 #include "Adje.h"
+#include "Ad.h"
 
 using namespace std;
 using namespace dsp;
@@ -45,14 +46,10 @@ Adje::Adje() {
 	configOutput(VPOCT_OUTPUT, "polyphonic V/oct");
 	configOutput(AMP_OUTPUT, "polyphonic amplitude");
 
-	blockSize = min(64, (int)(APP->engine->getSampleRate() / 750.f));
-	blockCounter = rand() % blockSize;
-
-	buf.init(
-		4.f * APP->engine->getSampleRate() / (float)blockSize,
-		16,
-		&cvBufferMode);
+	// (applyControlRate() sets the size)
+	buf.init(0, 16, &cvBufferMode, INT_MAX, getMaxCvBufferSize());
 	spec.init(31, &buf);
+	applyControlRate();
 
 	reset(true);
 }
@@ -64,6 +61,7 @@ json_t* Adje::dataToJson() {
 	json_object_set_new(rootJ, "cvBufferMode", json_integer(cvBufferMode));
 	json_object_set_new(rootJ, "emptyOnReset", json_boolean(emptyOnReset));
 	json_object_set_new(rootJ, "channels", json_integer(channels));
+	json_object_set_new(rootJ, "controlRate", json_integer(controlRate));
 	return rootJ;
 }
 
@@ -80,6 +78,9 @@ void Adje::dataFromJson(json_t* rootJ) {
 	json_t* channelsJ = json_object_get(rootJ, "channels");
 	if (channelsJ)
 		channels = json_integer_value(channelsJ);
+	json_t* controlRateJ = json_object_get(rootJ, "controlRate");
+	if (controlRateJ)
+		controlRate = (ControlRate)json_integer_value(controlRateJ);
 }
 
 void Adje::onReset(const ResetEvent& e) {
@@ -94,14 +95,24 @@ void Adje::onRandomize(const RandomizeEvent& e) {
 
 void Adje::onSampleRateChange(const SampleRateChangeEvent& e) {
 	Module::onSampleRateChange(e);
-	blockSize = min(64, (int)(APP->engine->getSampleRate() / 750.f));
-	blockCounter = rand() % blockSize;
+	// (The CV buffer keeps its contents, resampled to the new rate.)
+	applyControlRate();
+}
 
+// the block size and what depends on it
+void Adje::applyControlRate() {
+	appliedControlRate = controlRate;
+	blockSize = getBlockSize(controlRate, APP->engine->getSampleRate());
+	blockCounter = rand() % blockSize;
 	spec.setSmoothCoeff(1.f / (float)blockSize);
 	// 4 seconds buffer
-	buf.resize(
-		(int)(4.f * APP->engine->getSampleRate() / (float)blockSize));
-	reset(true);
+	buf.resize(getCvBufferSize(blockSize, APP->engine->getSampleRate()));
+}
+
+void Adje::onExpanderChange(const ExpanderChangeEvent& e) {
+	Module* rightModule = getRightExpander().module;
+	busRight = (rightModule && rightModule->getModel() == modelAd) ?
+		rightModule : nullptr;
 }
 
 void Adje::reset(bool set0) {
@@ -120,7 +131,30 @@ void Adje::reset(bool set0) {
 	}
 }
 
+void Adje::publishDisplay() {
+	Display& d = display.getBack();
+	d.channels = channels;
+	for (int i = 0; i < channels; i++) {
+		d.pitch[i] = pitch[i];
+		d.amp[i] = amp[i];
+	}
+	display.publish();
+}
+
 void Adje::process(const ProcessArgs& args) {
+	Ad::SpectrumBusMessage* busOut = (busRight) ?
+		(Ad::SpectrumBusMessage*)busRight->getLeftExpander().producerMessage :
+		nullptr;
+	if (busOut) {
+		busOut->channels = 0;
+		for (int k = 0; k < 16; k++)
+			busOut->fresh[k] = false;
+	}
+
+	// a new control rate from the menu
+	if (controlRate != appliedControlRate)
+		applyControlRate();
+
 	if (!(outputs[VPOCT_OUTPUT].isConnected() ||
 		outputs[AMP_OUTPUT].isConnected()))
 		reset(true);
@@ -152,6 +186,7 @@ void Adje::process(const ProcessArgs& args) {
 
 			if (blockCounter == 0) {
 				// Do the stuff we want to do once every block:
+				PROFILE_SCOPE(profiler, CONTROL);
 
 				// Get knob values.
 				float partials = params[PARTIALS_PARAM].getValue();
@@ -226,7 +261,7 @@ void Adje::process(const ProcessArgs& args) {
 
 						cvBufferDelay /= .95f;
 						// exponential mapping
-						cvBufferDelay = (powf(10.f, cvBufferDelay) - 1.f) / 9.f;
+						cvBufferDelay = (FastMath::pow10<FastMath::MEDIUM>(cvBufferDelay) - 1.f) / 9.f;
 						buf.setDelayRel(cvBufferDelay);
 						buf.push(.1f * inputs[CVBUFFER_INPUT].getVoltage());
 					}
@@ -245,12 +280,14 @@ void Adje::process(const ProcessArgs& args) {
 			isRandomized = true;
 			resetLight = 1.f;
 		} else if (!spec.ampsAre0()) {
+			PROFILE_SCOPE(profiler, SMOOTHING);
 			spec.smoothen();
 			isRandomized = false;
 		}
 
+		PROFILE_SCOPE(profiler, OUTPUT);
 		for (int i = spec.getLowest() - 1; i < spec.getLowest() + channels - 1; i++) {
-			float pitch_ = fundPitch + log2f(abs(1.f + i * stretch));
+			float pitch_ = fundPitch + FastMath::log2(abs(1.f + i * stretch));
 			if (abs(pitch_) <= 10.f) {
 				pitch[i % channels] = pitch_;
 				amp[i % channels] = abs(spec.getAmp(i));
@@ -264,11 +301,36 @@ void Adje::process(const ProcessArgs& args) {
 			}
 		}
 
+		// Our spectrum, for all the voices of the Ad to our right, once per
+		// block. (Ad's spectra have 128 partials, ours only 31.)
+		if (busOut) {
+			busOut->channels = 1;
+			if (blockCounter == 0) {
+				Spectrum::Result& result = busOut->results[0];
+				spec.getResult(result);
+				for (int i = spec.getOscs(); i < 128; i++)
+					result.amps[i] = 0.f;
+				busOut->fresh[0] = true;
+			}
+		}
+
 		lights[RESET_LIGHT].setBrightness(resetLight);
 
 		blockCounter++;
 		blockCounter %= blockSize;
 	}
+
+	if (busOut)
+		busRight->getLeftExpander().requestMessageFlip();
+
+	displayCounter++;
+	if (displayCounter >= args.sampleRate / 60.f) {
+		PROFILE_SCOPE(profiler, OUTPUT);
+		publishDisplay();
+		displayCounter = 0;
+	}
+
+	PROFILE_END_SAMPLE(profiler);
 }
 
 Model* modelAdje = createModel<Adje, AdjeWidget>("Adje");
\ No newline at end of file
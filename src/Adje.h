@@ -5,6 +5,9 @@
 #include "vanTies.h"
 #include "dsp/Spectrum.h"
 #include "dsp/AdditiveOscillator.h"
+#include "dsp/FastMath.h"
+#include "dsp/TripleBuffer.h"
+#include "dsp/Profiler.h"
 
 struct Adje : Module {
 	enum ParamId {
@@ -47,6 +50,10 @@ struct Adje : Module {
 	CvBuffer::Mode cvBufferMode = CvBuffer::LOW_HIGH;
 	bool emptyOnReset = false;
 	int channels = 16;
+	ControlRate controlRate = CONTROL_RATE_64;
+	// the control rate the block size is for (the menu sets controlRate, and
+	// process() catches up)
+	ControlRate appliedControlRate = CONTROL_RATE_64;
 
 	// A part of the code will be excecuted at a lower rate than the sample
 	int blockSize;
@@ -63,6 +70,25 @@ struct Adje : Module {
 	CvBuffer buf;
 	Spectrum spec;
 
+	// the Ad to our right, which can play our spectrum (see
+	// Ad::SpectrumBusMessage), set on expander changes
+	Module* busRight = nullptr;
+
+	// what the spectrum widget draws, published by the audio thread at
+	// about 60 fps
+	struct Display {
+		int channels = 0;
+		float pitch[16] = {};
+		float amp[16] = {};
+	};
+	TripleBuffer<Display> display;
+	int displayCounter = 0;
+
+#ifdef VANTIES_PROFILE
+	// the cycle counts of process(), see the context menu
+	Profiler profiler;
+#endif
+
 	Adje();
 
 	json_t* dataToJson() override;
@@ -70,7 +96,10 @@ struct Adje : Module {
 	void onReset(const ResetEvent& e) override;
 	void onRandomize(const RandomizeEvent& e) override;
 	void onSampleRateChange(const SampleRateChangeEvent& e) override;
+	void onExpanderChange(const ExpanderChangeEvent& e) override;
+	void applyControlRate();
 	void reset(bool set0);
+	void publishDisplay();
 	void process(const ProcessArgs& args) override;
 };
 
@@ -8,11 +8,14 @@ void AdjeSpectrumWidget::drawLayer(const DrawArgs& args, int layer) {
 		return;
 
 	if (layer == 1) {
+		module->display.update();
+		const Adje::Display& d = module->display.getFront();
+
 		nvgStrokeWidth(args.vg, 1.5f);
 
-		for (int i = 0; i < module->channels; i++) {
-			float x = (module->pitch[i] * .05f + .5f) * box.size.x;
-			float y = abs(module->amp[i]);
+		for (int i = 0; i < d.channels; i++) {
+			float x = (d.pitch[i] * .05f + .5f) * box.size.x;
+			float y = abs(d.amp[i]);
 			// Map the amplitudes logaritmically
 			// to corresponding y-values: 1 -> 1, 2^-9 -> 1/16 .
 			y = (y > .00128858194411415455f) ?
@@ -125,4 +128,15 @@ void AdjeWidget::appendContextMenu(Menu* menu) {
 				[=]() {module->channels = c;}
 			));
 		} }));
+
+	menu->addChild(createControlRateMenuItem(&module->controlRate));
+
+	// which variant of the DSP kernels runs on this CPU
+	menu->addChild(new MenuSeparator);
+	menu->addChild(createMenuLabel(std::string("DSP kernels: ")
+		+ DspKernels::getName(DspKernels::getIsa())));
+
+#ifdef VANTIES_PROFILE
+	appendProfilerMenu(menu, &module->profiler);
+#endif
 }
@@ -15,15 +15,10 @@ Bufke::Bufke() {
 
 	configOutput(CV_OUTPUT, "polyphonic CV");
 
-	blockSize = min(64, (int)(APP->engine->getSampleRate() / 750.f));
-	blockRatio = 1.f / (float)blockSize;
-	blockCounter = rand() % blockSize;
-
-	buf.init(
-		4.f * APP->engine->getSampleRate() / (float)blockSize,
-		31,
-		&cvBufferMode);
+	// (applyControlRate() sets the size)
+	buf.init(0, 31, &cvBufferMode, INT_MAX, getMaxCvBufferSize());
 	buf.setOn(true);
+	applyControlRate(controlRate);
 
 	reset();
 }
@@ -33,6 +28,7 @@ json_t* Bufke::dataToJson() {
 	json_object_set_new(rootJ, "cvBufferMode", json_integer(cvBufferMode));
 	json_object_set_new(rootJ, "emptyOnReset", json_boolean(emptyOnReset));
 	json_object_set_new(rootJ, "followMode", json_integer(buf.followMode));
+	json_object_set_new(rootJ, "controlRate", json_integer(controlRate));
 	return rootJ;
 }
 
@@ -46,6 +42,9 @@ void Bufke::dataFromJson(json_t* rootJ) {
 	json_t* followModeJ = json_object_get(rootJ, "followMode");
 	if (followModeJ)
 		buf.followMode = (FollowingCvBuffer::FollowMode)json_integer_value(followModeJ);
+	json_t* controlRateJ = json_object_get(rootJ, "controlRate");
+	if (controlRateJ)
+		controlRate = (ControlRate)json_integer_value(controlRateJ);
 }
 
 void Bufke::onReset(const ResetEvent& e) {
@@ -60,14 +59,18 @@ void Bufke::onRandomize(const RandomizeEvent& e) {
 
 void Bufke::onSampleRateChange(const SampleRateChangeEvent& e) {
 	Module::onSampleRateChange(e);
-	blockSize = min(64, (int)(APP->engine->getSampleRate() / 750.f));
-	blockCounter = rand() % blockSize;
-	blockRatio = 1.f / (float)blockSize;
+	// (The CV buffer keeps its contents, resampled to the new rate.)
+	applyControlRate(appliedControlRate);
+}
 
+// the block size and what depends on it
+void Bufke::applyControlRate(ControlRate controlRate) {
+	appliedControlRate = controlRate;
+	blockSize = getBlockSize(controlRate, APP->engine->getSampleRate());
+	blockRatio = 1.f / (float)blockSize;
+	blockCounter = rand() % blockSize;
 	// 4 seconds buffer
-	buf.resize(
-		(int)(4.f * APP->engine->getSampleRate() / (float)blockSize));
-	reset();
+	buf.resize(getCvBufferSize(blockSize, APP->engine->getSampleRate()));
 }
 
 void Bufke::onExpanderChange(const ExpanderChangeEvent& e) {
@@ -78,17 +81,20 @@ void Bufke::onExpanderChange(const ExpanderChangeEvent& e) {
 		masterChannels = &leftAdje->channels;
 		masterIsReset = &leftAdje->isReset;
 		masterIsRandomized = &leftAdje->isRandomized;
+		masterControlRate = &leftAdje->appliedControlRate;
 	} else if (leftModule && leftModule->getModel() == modelBufke) {
 		Bufke* leftBufke = static_cast<Bufke*>(leftModule);
 		masterBuf = &leftBufke->buf;
 		masterChannels = &leftBufke->channels;
 		masterIsReset = &leftBufke->isReset;
 		masterIsRandomized = &leftBufke->isRandomized;
+		masterControlRate = &leftBufke->appliedControlRate;
 	} else {
 		masterBuf = nullptr;
 		masterChannels = nullptr;
 		masterIsReset = nullptr;
 		masterIsRandomized = nullptr;
+		masterControlRate = nullptr;
 	}
 }
 
@@ -101,6 +107,17 @@ void Bufke::reset() {
 	}
 }
 
+void Bufke::publishDisplay() {
+	Display& d = display.getBack();
+	d.lowest = lowest;
+	d.highest = highest;
+	d.channels = channels;
+	for (int i = 0; i < channels; i++)
+		d.values[i] = valuesSmooth[i];
+	d.linked = masterBuf != nullptr;
+	display.publish();
+}
+
 void Bufke::process(const ProcessArgs& args) {
 	if (masterBuf && masterChannels) {
 		buf.setMasterCvBuffer(masterBuf);
@@ -115,6 +132,13 @@ void Bufke::process(const ProcessArgs& args) {
 	}
 	outputs[CV_OUTPUT].setChannels(channels);
 
+	// The delay times of the module we follow count in its blocks, so we
+	// take over its control rate.
+	ControlRate rate = (masterBuf && masterControlRate) ?
+		*masterControlRate : controlRate;
+	if (rate != appliedControlRate)
+		applyControlRate(rate);
+
 	if (blockCounter == 0)
 		resetLight *= 1.f - (8 * blockSize) * APP->engine->getSampleTime();
 
@@ -142,6 +166,7 @@ void Bufke::process(const ProcessArgs& args) {
 
 				if (blockCounter == 0) {
 					// Do the stuff we want to do once every block:
+					PROFILE_SCOPE(profiler, CONTROL);
 
 					// Get the knob value
 					float cvBufferDelay = params[CVBUFFER_DELAY_PARAM].getValue();
@@ -169,7 +194,7 @@ void Bufke::process(const ProcessArgs& args) {
 						buf.setFrozen(abs(cvBufferDelay) > .95f);
 						cvBufferDelay /= .95f;
 						// exponential mapping
-						cvBufferDelay = (powf(10.f, cvBufferDelay) - 1.f) / 9.f;
+						cvBufferDelay = (FastMath::pow10<FastMath::MEDIUM>(cvBufferDelay) - 1.f) / 9.f;
 						buf.setDelayRel(cvBufferDelay);
 						buf.push(inputs[CVBUFFER_INPUT].getVoltage());
 						buf.process();
@@ -180,15 +205,27 @@ void Bufke::process(const ProcessArgs& args) {
 		}
 	}
 
-	for (int i = lowest - 1; i < lowest + channels - 1; i++) {
-		valuesSmooth[i % channels] += blockRatio * (buf.getValue(i) - valuesSmooth[i % channels]);
-		outputs[CV_OUTPUT].setVoltage(valuesSmooth[i % channels], i % channels);
+	{
+		PROFILE_SCOPE(profiler, SMOOTHING);
+		for (int i = lowest - 1; i < lowest + channels - 1; i++) {
+			valuesSmooth[i % channels] += blockRatio * (buf.getValue(i) - valuesSmooth[i % channels]);
+			outputs[CV_OUTPUT].setVoltage(valuesSmooth[i % channels], i % channels);
+		}
 	}
 
 	lights[RESET_LIGHT].setBrightness(resetLight);
 
 	blockCounter++;
 	blockCounter %= blockSize;
+
+	displayCounter++;
+	if (displayCounter >= args.sampleRate / 60.f) {
+		PROFILE_SCOPE(profiler, OUTPUT);
+		publishDisplay();
+		displayCounter = 0;
+	}
+
+	PROFILE_END_SAMPLE(profiler);
 }
 
 Model* modelBufke = createModel<Bufke, BufkeWidget>("Bufke");
\ No newline at end of file
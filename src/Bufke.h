@@ -4,6 +4,9 @@
 #include "rack.hpp"
 #include "vanTies.h"
 #include "dsp/FollowingCvBuffer.h"
+#include "dsp/FastMath.h"
+#include "dsp/TripleBuffer.h"
+#include "dsp/Profiler.h"
 #include "Adje.h"
 
 struct Bufke : Module {
@@ -37,6 +40,11 @@ struct Bufke : Module {
 
 	bool resetSignal = false;
 
+	ControlRate controlRate = CONTROL_RATE_64;
+	// the control rate the block size is for: controlRate, or the one of the
+	// module to our left if we follow it (process() catches up with either)
+	ControlRate appliedControlRate = CONTROL_RATE_64;
+
 	// A part of the code will be excecuted at a lower rate than the sample
 	int blockSize;
 	float blockRatio;
@@ -54,6 +62,24 @@ struct Bufke : Module {
 	int* masterChannels = nullptr;
 	bool* masterIsReset = nullptr;
 	bool* masterIsRandomized = nullptr;
+	ControlRate* masterControlRate = nullptr;
+
+	// what the meter widget draws, published by the audio thread at
+	// about 60 fps
+	struct Display {
+		int lowest = 0;
+		int highest = 0;
+		int channels = 0;
+		float values[16] = {};
+		bool linked = false;
+	};
+	TripleBuffer<Display> display;
+	int displayCounter = 0;
+
+#ifdef VANTIES_PROFILE
+	// the cycle counts of process(), see the context menu
+	Profiler profiler;
+#endif
 
 	Bufke();
 
@@ -63,7 +89,9 @@ struct Bufke : Module {
 	void onRandomize(const RandomizeEvent& e) override;
 	void onSampleRateChange(const SampleRateChangeEvent& e) override;
 	void onExpanderChange(const ExpanderChangeEvent& e) override;
+	void applyControlRate(ControlRate controlRate);
 	void reset();
+	void publishDisplay();
 	void process(const ProcessArgs& args) override;
 };
 
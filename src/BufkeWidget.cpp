@@ -8,28 +8,30 @@ void BufkeMeterWidget::drawLayer(const DrawArgs& args, int layer) {
 		return;
 
 	if (layer == 1) {
+		module->display.update();
+		const Bufke::Display& d = module->display.getFront();
+
 		nvgStrokeWidth(args.vg, 1.f);
 
 		float width = box.size.x;
-		int partials = min(module->highest - module->lowest + 1,
-			module->channels);
+		int partials = min(d.highest - d.lowest + 1, d.channels);
 		if (partials > 0)
 			width /= (float)partials;
 
-		for (int i = module->lowest - 1; i < module->lowest + partials - 1; i++) {
+		for (int i = d.lowest - 1; i < d.lowest + partials - 1; i++) {
 			// Draw the lines.
-			if (module->valuesSmooth[i % module->channels] < 0.f)
+			if (d.values[i % d.channels] < 0.f)
 				nvgStrokeColor(args.vg, nvgRGBf(1.f, .5f, .5f));
 			else
 				nvgStrokeColor(args.vg, nvgRGBf(1.f, 1.f, .75f));
 			nvgBeginPath(args.vg);
-			nvgMoveTo(args.vg, (i - module->lowest + 1.5f) * width, .5f * box.size.y);
-			nvgLineTo(args.vg, (i - module->lowest + 1.5f) * width,
-				(-.05f * module->valuesSmooth[i % module->channels] + .5f) * box.size.y);
+			nvgMoveTo(args.vg, (i - d.lowest + 1.5f) * width, .5f * box.size.y);
+			nvgLineTo(args.vg, (i - d.lowest + 1.5f) * width,
+				(-.05f * d.values[i % d.channels] + .5f) * box.size.y);
 			nvgStroke(args.vg);
 		}
 
-		if (module->masterBuf) {
+		if (d.linked) {
 			nvgBeginPath(args.vg);
 			nvgFillColor(args.vg, nvgRGBf(1.f, .5f, .5f));
 			nvgFontSize(args.vg, 9.f);
@@ -95,4 +97,11 @@ void BufkeWidget::appendContextMenu(Menu* menu) {
 		 "Sync clock",
 		 "Get delay time" },
 		&module->buf.followMode));
+
+	// (When we follow the module to the left, we run at its control rate.)
+	menu->addChild(createControlRateMenuItem(&module->controlRate));
+
+#ifdef VANTIES_PROFILE
+	appendProfilerMenu(menu, &module->profiler);
+#endif
 }
\ No newline at end of file
@@ -33,8 +33,11 @@ Funs::Funs() {
 
   getParamQuantity(PITCH_PARAM)->randomizeEnabled = false;
 
-  for (int c = 0; c < 16; c++)
+  wavetable = RatFuncWavetable::acquire();
+  for (int c = 0; c < 16; c++) {
     osc[c].setSampleRate(APP->engine->getSampleRate());
+    osc[c].setWavetable(wavetable.get());
+  }
 }
 
 
@@ -42,6 +45,8 @@ json_t* Funs::dataToJson() {
   json_t* rootJ = json_object();
   json_object_set_new(rootJ, "pitchQuant",
     json_integer(pitchQuant));
+  json_object_set_new(rootJ, "antiAliasing",
+    json_integer(antiAliasing));
   return rootJ;
 }
 
@@ -49,6 +54,10 @@ void Funs::dataFromJson(json_t* rootJ) {
   json_t* pitchQuantJ = json_object_get(rootJ, "pitchQuant");
   if (pitchQuantJ)
     pitchQuant = (PitchQuant)json_integer_value(pitchQuantJ);
+  json_t* antiAliasingJ = json_object_get(rootJ, "antiAliasing");
+  if (antiAliasingJ)
+    antiAliasing =
+    (RatFuncOscillator::AntiAliasing)json_integer_value(antiAliasingJ);
 }
 
 void Funs::onSampleRateChange(const SampleRateChangeEvent& e) {
@@ -58,6 +67,17 @@ void Funs::onSampleRateChange(const SampleRateChangeEvent& e) {
   }
 }
 
+void Funs::publishDisplay() {
+  Display& d = display.getBack();
+  d.channels = channels;
+  for (int ch = 0; ch < channels; ch++) {
+    d.a[ch] = osc[ch].getA();
+    d.b[ch] = osc[ch].getB();
+    d.c[ch] = osc[ch].getC();
+  }
+  display.publish();
+}
+
 void Funs::process(const ProcessArgs& args) {
   // Get the number of polyphony channels from the V/oct input.
   channels = max(inputs[VPOCT_INPUT].getChannels(), 1);
@@ -65,6 +85,7 @@ void Funs::process(const ProcessArgs& args) {
   outputs[WAVE2_OUTPUT].setChannels(channels);
 
   for (int ch = 0; ch < channels; ch++) {
+    PROFILE_START(profiler);
     float pitch = params[PITCH_PARAM].getValue();
 
     if (pitchQuant == OCTAVES)
@@ -73,9 +94,9 @@ void Funs::process(const ProcessArgs& args) {
       pitch = round(12.f * pitch) / 12.f;
 
     pitch += inputs[VPOCT_INPUT].getPolyVoltage(ch);
-    pitch = 16.35159783128741466737f * exp2f(pitch);
+    pitch = 16.35159783128741466737f * FastMath::exp2(pitch);
     float fm = inputs[FM_INPUT].getPolyVoltage(ch) * .2f;
-    float fmAmt = exp2f(5.f * params[FMAMT_PARAM].getValue()) - 1.f;
+    float fmAmt = FastMath::exp2<FastMath::MEDIUM>(5.f * params[FMAMT_PARAM].getValue()) - 1.f;
     osc[ch].setFreq((1.f + fm * fmAmt) * pitch);
 
     float a = params[A_PARAM].getValue();
@@ -89,9 +110,12 @@ void Funs::process(const ProcessArgs& args) {
       * inputs[C_INPUT].getPolyVoltage(ch);
 
     osc[ch].setFreq(pitch);
+    osc[ch].setAntiAliasing(antiAliasing);
     osc[ch].setParams(a, b, c);
+    PROFILE_LAP(profiler, CONTROL);
 
     osc[ch].process();
+    PROFILE_LAP(profiler, SYNTHESIS);
 
     if (ch % 2) {
       outputs[WAVE1_OUTPUT].setVoltage(5.f * osc[ch].getWave(0), ch);
@@ -100,7 +124,17 @@ void Funs::process(const ProcessArgs& args) {
       outputs[WAVE1_OUTPUT].setVoltage(5.f * osc[ch].getWave(1), ch);
       outputs[WAVE2_OUTPUT].setVoltage(5.f * osc[ch].getWave(0), ch);
     }
+    PROFILE_LAP(profiler, OUTPUT);
+  }
+
+  displayCounter++;
+  if (displayCounter >= args.sampleRate / 60.f) {
+    PROFILE_SCOPE(profiler, OUTPUT);
+    publishDisplay();
+    displayCounter = 0;
   }
+
+  PROFILE_END_SAMPLE(profiler);
 }
 
 Model* modelFuns = createModel<Funs, FunsWidget>("Funs");
@@ -14,6 +14,10 @@
 #include "rack.hpp"
 #include "vanTies.h"
 #include "dsp/RatFuncOscillator.h"
+#include "dsp/RatFuncWavetable.h"
+#include "dsp/FastMath.h"
+#include "dsp/TripleBuffer.h"
+#include "dsp/Profiler.h"
 
 struct Funs : Module {
   enum ParamId {
@@ -54,22 +58,80 @@ struct Funs : Module {
   Funs();
 
   RatFuncOscillator osc[16];
+  std::shared_ptr<RatFuncWavetable> wavetable;
+
+  // what the scope widget draws, published by the audio thread at
+  // about 60 fps
+  struct Display {
+    int channels = 0;
+    float a[16] = {};
+    float b[16] = {};
+    float c[16] = {};
+  };
+  TripleBuffer<Display> display;
+  int displayCounter = 0;
+
+#ifdef VANTIES_PROFILE
+  // the cycle counts of process(), see the context menu
+  Profiler profiler;
+#endif
 
   int channels = 0;
   PitchQuant pitchQuant = CONTINUOUS;
+  RatFuncOscillator::AntiAliasing antiAliasing =
+    RatFuncOscillator::LIMIT_PARAMS;
 
   json_t* dataToJson() override;
   void dataFromJson(json_t* rootJ) override;
   void onSampleRateChange(const SampleRateChangeEvent& e) override;
+  void publishDisplay();
   void process(const ProcessArgs& args) override;
 };
 
-struct FunsScopeWidget : Widget {
+struct FunsScopeLinesWidget;
+
+// The waves are drawn in a framebuffer, which is only redrawn when a, b or c
+// change. We show it in the light layer, so that it stays visible when the
+// room lights are dimmed.
+struct FunsScopeWidget : FramebufferWidget {
+  // the number of line segments per wave
+  static constexpr int POINTS = 128;
+
   Funs* module;
+  FunsScopeLinesWidget* linesWidget;
+  // an oscillator of our own, only for evaluating the wave functions
+  RatFuncOscillator osc;
 
+  // the polylines and reference points of the two waves of a channel,
+  // relative to the size of the widget, for the a, b and c they were
+  // computed for
+  struct Cache {
+    bool valid = false;
+    float a = 0.f;
+    float b = 0.f;
+    float c = 0.f;
+    float wave[2][POINTS] = {};
+    Vec dots[2][5];
+    int dotsLen[2] = {};
+  };
+  Cache cache[16];
+  int channels = 0;
+
+  FunsScopeWidget();
+  void updateCache(int c, float a, float b, float cc);
+  void step() override;
+  void draw(const DrawArgs& args) override;
   void drawLayer(const DrawArgs& args, int layer) override;
 };
 
+// draws the waves of a FunsScopeWidget into its framebuffer,
+// one path per color
+struct FunsScopeLinesWidget : Widget {
+  FunsScopeWidget* scope;
+
+  void draw(const DrawArgs& args) override;
+};
+
 struct FunsWidget : ModuleWidget {
   FunsWidget(Funs* module);
 
@@ -2,114 +2,121 @@
 
 using namespace std;
 
+FunsScopeWidget::FunsScopeWidget() {
+  linesWidget = new FunsScopeLinesWidget;
+  linesWidget->scope = this;
+  addChild(linesWidget);
+}
+
+// Evaluate the waves and their reference points for channel c, with the
+// parameters a, b and cc.
+void FunsScopeWidget::updateCache(int c, float a, float b, float cc) {
+  Cache& ca = cache[c];
+  ca.valid = true;
+  ca.a = a;
+  ca.b = b;
+  ca.c = cc;
+  osc.setShape(a, b, cc);
+
+  for (int i = 0; i < POINTS; i++) {
+    float x = (float)(i + 1) / POINTS;
+    ca.wave[0][i] = .5f - .5f * osc.waveFunction1(x);
+    ca.wave[1][i] = .5f - .5f * osc.waveFunction2(x);
+  }
+
+  // the points where the waves reach 1, 1/2 sqrt(2), -1 and -1/2 sqrt(2),
+  // and the zero crossing of wave 1
+  ca.dots[0][0] = Vec(cc, .5f);
+  ca.dots[0][1] = Vec(osc.phaseDistortInv1(a), 0.f);
+  ca.dots[0][2] = Vec(osc.phaseDistortInv1(b), .5f - .5f * M_SQRT1_2);
+  ca.dots[0][3] = Vec(osc.phaseDistortInv1(1.f - a), 1.f);
+  ca.dots[0][4] = Vec(osc.phaseDistortInv1(1.f - b), .5f + .5f * M_SQRT1_2);
+  ca.dotsLen[0] = 5;
+  ca.dots[1][0] = Vec(osc.phaseDistortInv2(a), 0.f);
+  ca.dots[1][1] = Vec(osc.phaseDistortInv2(b), .5f - .5f * M_SQRT1_2);
+  ca.dots[1][2] = Vec(osc.phaseDistortInv2(1.f - a), 1.f);
+  ca.dots[1][3] = Vec(osc.phaseDistortInv2(1.f - b), .5f + .5f * M_SQRT1_2);
+  ca.dotsLen[1] = 4;
+}
+
+void FunsScopeWidget::step() {
+  if (module && module->display.update()) {
+    const Funs::Display& d = module->display.getFront();
+    bool changed = d.channels != channels;
+    channels = d.channels;
+    for (int c = 0; c < channels; c++) {
+      if (!cache[c].valid
+        || cache[c].a != d.a[c]
+        || cache[c].b != d.b[c]
+        || cache[c].c != d.c[c]) {
+        updateCache(c, d.a[c], d.b[c], d.c[c]);
+        changed = true;
+      }
+    }
+    if (changed)
+      setDirty();
+  }
+  linesWidget->box.size = box.size;
+  FramebufferWidget::step();
+}
+
+void FunsScopeWidget::draw(const DrawArgs& args) {
+  // Nothing here, we draw in the light layer.
+}
+
 void FunsScopeWidget::drawLayer(const DrawArgs& args, int layer) {
   if (!module)
     return;
 
-  if (layer == 1) {
-    nvgStrokeWidth(args.vg, 1.f);
-    nvgLineCap(args.vg, NVG_ROUND);
-    nvgLineJoin(args.vg, NVG_ROUND);
-
-    for (int c = module->channels - 1; c >= 0; c--) {
-      if (!(c % 2)) {
-        nvgStrokeColor(args.vg, nvgRGBf(1.f, .5f, .5f));
-        nvgFillColor(args.vg, nvgRGBf(1.f, .5f, .5f));
-      } else {
-        nvgStrokeColor(args.vg, nvgRGBf(1., 1.f, .75f));
-        nvgFillColor(args.vg, nvgRGBf(1.f, 1.f, .75f));
-      }
+  if (layer == 1)
+    FramebufferWidget::draw(args);
 
-      nvgBeginPath(args.vg);
-      nvgMoveTo(args.vg, 0.f, .5f * box.size.y);
-      for (float x = 7.8125e-3f; x <= 1.f; x += 7.8125e-3f) // 1/128
-        nvgLineTo(args.vg,
-          x * box.size.x,
-          (.5f - .5f * module->osc[c].waveFunction2(x)) * box.size.y);
-      nvgStroke(args.vg);
-
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv2(module->osc[c].getA()) * box.size.x,
-        0.f,
-        1.f);
-      nvgFill(args.vg);
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv2(module->osc[c].getB()) * box.size.x,
-        (.5f - .5f * M_SQRT1_2) * box.size.y,
-        1.f);
-      nvgFill(args.vg);
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv2(1.f - module->osc[c].getA()) * box.size.x,
-        box.size.y,
-        1.f);
-      nvgFill(args.vg);
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv2(1.f - module->osc[c].getB()) * box.size.x,
-        (.5f + .5f * M_SQRT1_2) * box.size.y,
-        1.f);
-      nvgFill(args.vg);
-
-      if (c % 2) {
-        nvgStrokeColor(args.vg, nvgRGBf(1.f, .5f, .5f));
-        nvgFillColor(args.vg, nvgRGBf(1.f, .5f, .5f));
-      } else {
-        nvgStrokeColor(args.vg, nvgRGBf(1., 1.f, .75f));
-        nvgFillColor(args.vg, nvgRGBf(1.f, 1.f, .75f));
-      }
+  FramebufferWidget::drawLayer(args, layer);
+}
+
+void FunsScopeLinesWidget::draw(const DrawArgs& args) {
+  NVGcolor color[2] = {
+    nvgRGBf(1.f, .5f, .5f),
+    nvgRGBf(1.f, 1.f, .75f)
+  };
+  float w = box.size.x;
+  float h = box.size.y;
 
-      nvgBeginPath(args.vg);
-      nvgMoveTo(args.vg, 0.f, .5f * box.size.y);
-      for (float x = 7.8125e-3f; x <= 1.f; x += 7.8125e-3f) // 1/128
+  nvgStrokeWidth(args.vg, 1.f);
+  nvgLineCap(args.vg, NVG_ROUND);
+  nvgLineJoin(args.vg, NVG_ROUND);
+
+  // The two waves are flipped for the odd numbered channels, so wave i of
+  // channel c gets color (i + c + 1) % 2 .
+  for (int k = 0; k < 2; k++) {
+    nvgStrokeColor(args.vg, color[k]);
+    nvgFillColor(args.vg, color[k]);
+
+    nvgBeginPath(args.vg);
+    for (int c = scope->channels - 1; c >= 0; c--) {
+      const FunsScopeWidget::Cache& ca = scope->cache[c];
+      int i = (k + c + 1) % 2;
+      nvgMoveTo(args.vg, 0.f, .5f * h);
+      for (int j = 0; j < FunsScopeWidget::POINTS; j++)
         nvgLineTo(args.vg,
-          x * box.size.x,
-          (.5f - .5f * module->osc[c].waveFunction1(x)) * box.size.y);
-      nvgStroke(args.vg);
-
-
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].getC() * box.size.x,
-        .5f * box.size.y,
-        1.f);
-      nvgFill(args.vg);
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv1(module->osc[c].getA()) * box.size.x,
-        0.f,
-        1.f);
-      nvgFill(args.vg);
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv1(module->osc[c].getB()) * box.size.x,
-        (.5f - .5f * M_SQRT1_2) * box.size.y,
-        1.f);
-      nvgFill(args.vg);
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv1(1.f - module->osc[c].getA()) * box.size.x,
-        box.size.y,
-        1.f);
-      nvgFill(args.vg);
-      nvgBeginPath(args.vg);
-      nvgCircle(args.vg,
-        module->osc[c].phaseDistortInv1(1.f - module->osc[c].getB()) * box.size.x,
-        (.5f + .5f * M_SQRT1_2) * box.size.y,
-        1.f);
-      nvgFill(args.vg);
+          (float)(j + 1) / FunsScopeWidget::POINTS * w,
+          ca.wave[i][j] * h);
     }
+    nvgStroke(args.vg);
 
     nvgBeginPath(args.vg);
-    nvgCircle(args.vg, 0.f, .5f * box.size.y, 1.f);
-    nvgFill(args.vg);
-    nvgBeginPath(args.vg);
-    nvgCircle(args.vg, box.size.x, .5f * box.size.y, 1.f);
+    for (int c = scope->channels - 1; c >= 0; c--) {
+      const FunsScopeWidget::Cache& ca = scope->cache[c];
+      int i = (k + c + 1) % 2;
+      for (int j = 0; j < ca.dotsLen[i]; j++)
+        nvgCircle(args.vg, ca.dots[i][j].x * w, ca.dots[i][j].y * h, 1.f);
+    }
+    if (k == 1) {
+      nvgCircle(args.vg, 0.f, .5f * h, 1.f);
+      nvgCircle(args.vg, w, .5f * h, 1.f);
+    }
     nvgFill(args.vg);
   }
-  Widget::drawLayer(args, layer);
 }
 
 FunsWidget::FunsWidget(Funs* module) {
@@ -175,4 +182,15 @@ void FunsWidget::appendContextMenu(Menu* menu) {
      "Semitones",
      "Octaves" },
     &module->pitchQuant));
+
+  menu->addChild(createIndexPtrSubmenuItem(
+    "Anti-aliasing",
+    { "Limit parameters",
+     "Antiderivative (ADAA)",
+     "Wavetable" },
+    &module->antiAliasing));
+
+#ifdef VANTIES_PROFILE
+  appendProfilerMenu(menu, &module->profiler);
+#endif
 }
\ No newline at end of file
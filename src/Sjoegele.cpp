@@ -32,6 +32,14 @@ json_t* Sjoegele::dataToJson() {
 	json_t* rootJ = json_object();
 	json_object_set_new(rootJ, "x2y2Relative",
 		json_boolean(x2y2Relative));
+	json_object_set_new(rootJ, "integrator",
+		json_integer(integrator));
+	json_object_set_new(rootJ, "simRate",
+		json_integer(simRate));
+	json_object_set_new(rootJ, "links",
+		json_integer(links));
+	json_object_set_new(rootJ, "showTrail",
+		json_boolean(showTrail));
 	return rootJ;
 }
 
@@ -39,12 +47,27 @@ void Sjoegele::dataFromJson(json_t* rootJ) {
 	json_t* x2y2RelativeJ = json_object_get(rootJ, "x2y2Relative");
 	if (x2y2RelativeJ)
 		x2y2Relative = json_boolean_value(x2y2RelativeJ);
+	// Patches from before these options simulated with semi-implicit Euler
+	// steps at audio rate, so they keep doing that.
+	json_t* integratorJ = json_object_get(rootJ, "integrator");
+	integrator = (integratorJ) ?
+		(DoublePendulumBank::Integrator)json_integer_value(integratorJ) :
+		DoublePendulumBank::SEMI_IMPLICIT_EULER;
+	json_t* simRateJ = json_object_get(rootJ, "simRate");
+	simRate = (simRateJ) ? (SimRate)json_integer_value(simRateJ) : AUDIO_RATE;
+	json_t* linksJ = json_object_get(rootJ, "links");
+	if (linksJ)
+		links = clamp((int)json_integer_value(linksJ),
+			2, ChainPendulumBank::MAX_LINKS);
+	json_t* showTrailJ = json_object_get(rootJ, "showTrail");
+	if (showTrailJ)
+		showTrail = json_boolean_value(showTrailJ);
 }
 
 void Sjoegele::onSampleRateChange(const SampleRateChangeEvent& e) {
 	Module::onSampleRateChange(e);
-	for (int c = 0; c < 16; c++)
-		pend[c].setSampleRate(APP->engine->getSampleRate());
+	pend.setSampleRate(APP->engine->getSampleRate());
+	chain.setSampleRate(APP->engine->getSampleRate());
 }
 
 void Sjoegele::onReset(const ResetEvent& e) {
@@ -64,55 +87,233 @@ void Sjoegele::start(int c) {
 	float g = params[G_PARAM].getValue();
 	l += .4f * inputs[L_INPUT].getPolyVoltage(c);
 	g += 1.2f * inputs[G_INPUT].getPolyVoltage(c);
-	l = powf(10.f, l);
+	l = FastMath::pow10<FastMath::MEDIUM>(l);
 	g = 9.8f * exp2_taylor5(g);
 
-	pend[c].setLength(l);
-	pend[c].setGravity(g);
-	pend[c].init();
+	if (simLinks == 2) {
+		pend.setLength(c, l);
+		pend.setGravity(c, g);
+		pend.init(c);
+	} else {
+		chain.setLength(c, l);
+		chain.setGravity(c, g);
+		chain.init(c);
+	}
+	updatePositions(c, true);
+	trail[c].push({ NAN, NAN });
+}
+
+// Take over the positions and the gates from the pendulum as the current
+// ones. If jump is false, the current ones become the previous ones, else
+// there's nothing to interpolate.
+void Sjoegele::updatePositions(int c, bool jump) {
+	if (!jump) {
+		for (int i = 0; i < 2 * simLinks; i++)
+			pos[c][0][i] = pos[c][1][i];
+		gates[c][0][0] = gates[c][1][0];
+		gates[c][0][1] = gates[c][1][1];
+	}
+	if (simLinks == 2) {
+		pos[c][1][0] = pend.getX1(c);
+		pos[c][1][1] = pend.getY1(c);
+		pos[c][1][2] = pend.getX2Rel(c);
+		pos[c][1][3] = pend.getY2Rel(c);
+		gates[c][1][0] = pend.th1Is0(c);
+		gates[c][1][1] = pend.th2Is0(c);
+	} else {
+		for (int k = 0; k < simLinks; k++) {
+			pos[c][1][2 * k] = chain.getX(c, k);
+			pos[c][1][2 * k + 1] = chain.getY(c, k);
+		}
+		gates[c][1][0] = chain.thIs0(c, 0);
+		gates[c][1][1] = chain.thIs0(c, simLinks - 1);
+	}
+	if (jump) {
+		for (int i = 0; i < 2 * simLinks; i++)
+			pos[c][0][i] = pos[c][1][i];
+		gates[c][0][0] = gates[c][1][0];
+		gates[c][0][1] = gates[c][1][1];
+	}
+}
+
+// the position of the last mass, in the coordinates of the display
+void Sjoegele::getTip(int c, float* x, float* y) {
+	*x = 0.f;
+	*y = 0.f;
+	for (int k = 0; k < simLinks; k++) {
+		*x += pos[c][1][2 * k];
+		*y += pos[c][1][2 * k + 1];
+	}
+	*x *= 2.f / simLinks;
+	*y *= 2.f / simLinks;
+}
+
+void Sjoegele::publishDisplay() {
+	Display& d = display.getBack();
+	d.channels = channels;
+	d.links = simLinks;
+	float scale = 2.f / simLinks;
+	for (int c = 0; c < channels; c++) {
+		float x = 0.f;
+		float y = 0.f;
+		for (int k = 0; k < simLinks; k++) {
+			x += pos[c][1][2 * k];
+			y += pos[c][1][2 * k + 1];
+			d.x[c][k] = scale * x;
+			d.y[c][k] = scale * y;
+		}
+	}
+	display.publish();
+}
+
+// For a chain, the x1 and y1 outputs give the absolute positions of all the
+// masses of the first pendulum, and the x2 and y2 outputs the position of the
+// last mass of each pendulum. The absolute positions are scaled to the length
+// of the whole chain. The gates are for the first and the last link.
+void Sjoegele::processChainOutputs(int c, const float* p, const bool* gate) {
+	float scale = 5.f / simLinks;
+	float x = 0.f;
+	float y = 0.f;
+	for (int k = 0; k < simLinks; k++) {
+		x += p[2 * k];
+		y += p[2 * k + 1];
+		if (c == 0) {
+			outputs[X1_OUTPUT].setVoltage(scale * x, k);
+			outputs[Y1_OUTPUT].setVoltage(scale * (y + simLinks), k);
+		}
+	}
+	if (x2y2Relative) {
+		outputs[X2_OUTPUT].setVoltage(5.f * p[2 * simLinks - 2], c);
+		outputs[Y2_OUTPUT].setVoltage(5.f * (p[2 * simLinks - 1] + 1.f), c);
+	} else {
+		outputs[X2_OUTPUT].setVoltage(scale * x, c);
+		outputs[Y2_OUTPUT].setVoltage(scale * (y + simLinks), c);
+	}
+	outputs[TH1IS0_OUTPUT].setVoltage((gate[0]) ? 5.f : 0.f, c);
+	outputs[TH2IS0_OUTPUT].setVoltage((gate[1]) ? 5.f : 0.f, c);
 }
 
 void Sjoegele::process(const ProcessArgs& args) {
 	channels = 1;
 	for (int i = 0; i < INPUTS_LEN; i++)
 		channels = max(channels, inputs[i].getChannels());
+	// Switching between the double and the chain pendulum, or changing the
+	// number of links, restarts all the pendulums.
+	if (links != simLinks) {
+		simLinks = links;
+		chain.setLinks(simLinks);
+		startUp = true;
+	}
+
 	for (int o = 0; o < OUTPUTS_LEN; o++)
 		outputs[o].setChannels(channels);
+	// For a chain, the x1 and y1 outputs have a channel for each link of the
+	// first pendulum.
+	if (simLinks > 2) {
+		outputs[X1_OUTPUT].setChannels(simLinks);
+		outputs[Y1_OUTPUT].setChannels(simLinks);
+	}
 
-	for (int c = 0; c < channels; c++) {
-		float cof = params[FRICTION_PARAM].getValue();
-		cof += .1f * inputs[FRICTION_INPUT].getPolyVoltage(c);
-		cof = pow(10.f, 8.f * cof) - 1.f;
-		// cof *= 1.e8f;
-		pend[c].setCOF(cof);
+	// The pendulums are simulated once every block, and the outputs are
+	// interpolated in between.
+	int blockSize = 1 << (2 * simRate);
+	if (blockCounter >= blockSize)
+		blockCounter = 0;
+	float t = (float)(blockCounter + 1) / (float)blockSize;
 
+	PROFILE_START(profiler);
+	for (int c = 0; c < channels; c++) {
 		initSignal[c] = (params[INIT_PARAM].getValue() > 0.f)
 			|| (inputs[INIT_INPUT].getPolyVoltage(c) > 2.5f);
 		if ((initSignal[c] && !isInit[c]) || startUp) {
 			start(c);
 
 			isInit[c] = true;
+		} else if (!initSignal[c]) {
+			isInit[c] = false;
+		}
+
+		if (blockCounter == 0) {
+			float cof = params[FRICTION_PARAM].getValue();
+			cof += .1f * inputs[FRICTION_INPUT].getPolyVoltage(c);
+			cof = FastMath::pow10<FastMath::MEDIUM>(8.f * cof) - 1.f;
+			if (simLinks == 2)
+				pend.setCOF(c, cof);
+			else
+				chain.setCOF(c, cof);
+		}
+	}
+
+	PROFILE_LAP(profiler, CONTROL);
+
+	// all the channels are simulated in one go
+	if (blockCounter == 0) {
+		if (simLinks == 2) {
+			pend.setChannels(channels);
+			pend.setIntegrator(integrator);
+			pend.process(blockSize * args.sampleTime);
 		} else {
-			if (!initSignal[c])
-				isInit[c] = false;
+			chain.setChannels(channels);
+			chain.setIntegrator(integrator);
+			chain.process(blockSize * args.sampleTime);
+		}
+		for (int c = 0; c < channels; c++)
+			updatePositions(c, false);
+	}
+	PROFILE_LAP(profiler, SYNTHESIS);
 
-			pend[c].process();
+	for (int c = 0; c < channels; c++) {
+		float p[2 * ChainPendulumBank::MAX_LINKS];
+		for (int i = 0; i < 2 * simLinks; i++)
+			p[i] = pos[c][0][i] + t * (pos[c][1][i] - pos[c][0][i]);
+		// The angle went through 0 (or pi) somewhere between the two steps,
+		// so the gates switch halfway.
+		const bool* gate = gates[c][(t >= .5f) ? 1 : 0];
+
+		if (simLinks > 2) {
+			processChainOutputs(c, p, gate);
+			continue;
 		}
 
-		outputs[X1_OUTPUT].setVoltage(5.f * pend[c].getX1(), c);
-		outputs[Y1_OUTPUT].setVoltage(5.f * (pend[c].getY1() + 1.f), c);
+		outputs[X1_OUTPUT].setVoltage(5.f * p[0], c);
+		outputs[Y1_OUTPUT].setVoltage(5.f * (p[1] + 1.f), c);
 		if (x2y2Relative) {
-			outputs[X2_OUTPUT].setVoltage(5.f * pend[c].getX2Rel(), c);
-			outputs[Y2_OUTPUT].setVoltage(5.f * (pend[c].getY2Rel() + 1.f), c);
+			outputs[X2_OUTPUT].setVoltage(5.f * p[2], c);
+			outputs[Y2_OUTPUT].setVoltage(5.f * (p[3] + 1.f), c);
 		} else {
-			outputs[X2_OUTPUT].setVoltage(2.5f * pend[c].getX2Abs(), c);
-			outputs[Y2_OUTPUT].setVoltage(2.5f * (pend[c].getY2Abs() + 2.f), c);
+			outputs[X2_OUTPUT].setVoltage(2.5f * (p[0] + p[2]), c);
+			outputs[Y2_OUTPUT].setVoltage(2.5f * (p[1] + p[3] + 2.f), c);
 		}
-		outputs[TH1IS0_OUTPUT].setVoltage((pend[c].th1Is0()) ? 5.f : 0.f, c);
-		outputs[TH2IS0_OUTPUT].setVoltage((pend[c].th2Is0()) ? 5.f : 0.f, c);
+		outputs[TH1IS0_OUTPUT].setVoltage((gate[0]) ? 5.f : 0.f, c);
+		outputs[TH2IS0_OUTPUT].setVoltage((gate[1]) ? 5.f : 0.f, c);
 	}
 
+	PROFILE_LAP(profiler, OUTPUT);
+
 	startUp = false;
+
+	blockCounter++;
+	blockCounter %= blockSize;
+
+	displayCounter++;
+	if (displayCounter >= args.sampleRate / 60.f) {
+		PROFILE_SCOPE(profiler, OUTPUT);
+		publishDisplay();
+		displayCounter = 0;
+	}
+
+	trailCounter++;
+	if (trailCounter >= args.sampleRate / TRAIL_RATE) {
+		PROFILE_SCOPE(profiler, OUTPUT);
+		for (int c = 0; c < channels; c++) {
+			TrailPoint p;
+			getTip(c, &p.x, &p.y);
+			trail[c].push(p);
+		}
+		trailCounter = 0;
+	}
+
+	PROFILE_END_SAMPLE(profiler);
 }
 
 Model* modelSjoegele = createModel<Sjoegele, SjoegeleWidget>("Sjoegele");
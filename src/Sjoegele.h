@@ -3,7 +3,12 @@
 #include <cmath>
 #include "rack.hpp"
 #include "vanTies.h"
-#include "dsp/DoublePendulum.h"
+#include "dsp/DoublePendulumBank.h"
+#include "dsp/ChainPendulumBank.h"
+#include "dsp/FastMath.h"
+#include "dsp/TripleBuffer.h"
+#include "dsp/Profiler.h"
+#include "dsp/RingBuffer.h"
 
 struct Sjoegele : Module {
 	enum ParamId {
@@ -33,7 +38,24 @@ struct Sjoegele : Module {
 		LIGHTS_LEN
 	};
 
+	// the rate at which the pendulums are simulated:
+	// the sample rate / 4^simRate
+	enum SimRate {
+		AUDIO_RATE,
+		QUARTER_RATE,
+		SIXTEENTH_RATE
+	};
+
 	bool x2y2Relative = false;
+	// the number of links: 2 for the double pendulum, or 3 to 8 for a chain
+	// pendulum, as set in the menu, and as it is being simulated
+	int links = 2;
+	int simLinks = 2;
+	// (for new instances, older patches load with semi-implicit Euler at
+	// audio rate, see dataFromJson())
+	DoublePendulumBank::Integrator integrator = DoublePendulumBank::RK4;
+	SimRate simRate = SIXTEENTH_RATE;
+	int blockCounter = 0;
 
 	int channels = 0;
 
@@ -41,7 +63,47 @@ struct Sjoegele : Module {
 	bool isInit[16] = {};
 	bool startUp = true;
 
-	DoublePendulum pend[16];
+	// all the pendulums, simulated side by side
+	DoublePendulumBank pend;
+	ChainPendulumBank chain;
+	// the positions x and y of the ends of the links, relative to their
+	// beginnings, of the previous and the current simulation step, we
+	// interpolate between them
+	float pos[16][2][2 * ChainPendulumBank::MAX_LINKS] = {};
+	// the theta = 0 gates of the first and the last link, of the same
+	// simulation steps as pos, so that they switch with the positions
+	bool gates[16][2][2] = {};
+
+	// what the display widget draws, published by the audio thread at
+	// about 60 fps
+	// The positions are absolute, and scaled such that the whole pendulum
+	// has length 2.
+	struct Display {
+		int channels = 0;
+		int links = 2;
+		float x[16][ChainPendulumBank::MAX_LINKS] = {};
+		float y[16][ChainPendulumBank::MAX_LINKS] = {};
+	};
+	TripleBuffer<Display> display;
+	int displayCounter = 0;
+
+#ifdef VANTIES_PROFILE
+	// the cycle counts of process(), see the context menu
+	Profiler profiler;
+#endif
+
+	// the trails of the last masses, in the same coordinates as the display,
+	// sampled at a fixed rate, whatever the sample rate
+	// A restart is marked with a NaN point, so the trail doesn't jump.
+	static constexpr float TRAIL_RATE = 120.f;
+	struct TrailPoint {
+		float x, y;
+	};
+	bool showTrail = true;
+	// (The last elements may be overwritten while the UI thread reads them,
+	// so it reads fewer than this.)
+	RingBuffer<TrailPoint, 128> trail[16];
+	int trailCounter = 0;
 
 	Sjoegele();
 
@@ -51,12 +113,17 @@ struct Sjoegele : Module {
 	void onReset(const ResetEvent& e) override;
 	void onRandomize(const RandomizeEvent& e) override;
 	void start(int c);
+	void updatePositions(int c, bool jump);
+	void publishDisplay();
+	void getTip(int c, float* x, float* y);
+	void processChainOutputs(int c, const float* p, const bool* gate);
 	void process(const ProcessArgs& args) override;
 };
 
 struct SjoegeleDisplayWidget : Widget {
 	Sjoegele* module;
 
+	void drawTrails(const DrawArgs& args, int channels);
 	void drawLayer(const DrawArgs& args, int layer) override;
 };
 
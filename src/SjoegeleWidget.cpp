@@ -3,41 +3,85 @@
 using namespace std;
 using namespace dsp;
 
+// The trails fade out in a few bands of decreasing opacity, each drawn as a
+// single path for all the channels.
+void SjoegeleDisplayWidget::drawTrails(const DrawArgs& args, int channels) {
+	static constexpr int POINTS = 120;
+	static constexpr int BANDS = 4;
+	static constexpr int BAND_POINTS = POINTS / BANDS;
+
+	Sjoegele::TrailPoint points[16][POINTS];
+	int n[16];
+	for (int c = 0; c < channels; c++)
+		n[c] = module->trail[c].read(points[c], POINTS);
+
+	for (int b = 0; b < BANDS; b++) {
+		nvgBeginPath(args.vg);
+		for (int c = 0; c < channels; c++) {
+			// The bands are counted from the newest point backwards, and
+			// overlap by one point.
+			int end = n[c] - b * BAND_POINTS;
+			int begin = max(end - BAND_POINTS - 1, 0);
+			bool penDown = false;
+			for (int i = begin; i < end; i++) {
+				const Sjoegele::TrailPoint& p = points[c][i];
+				if (std::isnan(p.x)) {
+					penDown = false;
+					continue;
+				}
+				float x = (p.x * .25f + .5f) * box.size.y;
+				float y = (-p.y * .25f + .5f) * box.size.y;
+				if (penDown)
+					nvgLineTo(args.vg, x, y);
+				else
+					nvgMoveTo(args.vg, x, y);
+				penDown = true;
+			}
+		}
+		nvgStrokeColor(args.vg,
+			nvgRGBAf(1.f, .75f, .625f, .4f * (BANDS - b) / BANDS));
+		nvgStroke(args.vg);
+	}
+}
+
 void SjoegeleDisplayWidget::drawLayer(const DrawArgs& args, int layer) {
 	if (!module)
 		return;
 
 	if (layer == 1) {
+		module->display.update();
+		const Sjoegele::Display& d = module->display.getFront();
+
 		nvgStrokeWidth(args.vg, 1.f);
 		nvgLineCap(args.vg, NVG_ROUND);
 		nvgLineJoin(args.vg, NVG_ROUND);
 
-		for (int c = module->channels - 1; c >= 0; c--) {
+		if (module->showTrail)
+			drawTrails(args, d.channels);
+
+		for (int c = d.channels - 1; c >= 0; c--) {
 			float g = 1.f;
 			float b = .75f;
-			if (module->channels != 1) {
-				g -= .5f * (float)c / (float)(module->channels - 1);
-				b -= .25f * (float)c / (float)(module->channels - 1);
+			if (d.channels != 1) {
+				g -= .5f * (float)c / (float)(d.channels - 1);
+				b -= .25f * (float)c / (float)(d.channels - 1);
 			}
 			nvgStrokeColor(args.vg, nvgRGBf(1., g, b));
 			nvgFillColor(args.vg, nvgRGBf(1.f, g, b));
 
-			float x1 = (module->pend[c].getX1() * .25f + .5f) * box.size.y;
-			float y1 = (-module->pend[c].getY1() * .25f + .5f) * box.size.y;
-			float x2 = (module->pend[c].getX2Abs() * .25f + .5f) * box.size.y;
-			float y2 = (-module->pend[c].getY2Abs() * .25f + .5f) * box.size.y;
-
 			nvgBeginPath(args.vg);
 			nvgMoveTo(args.vg, box.size.y * .5f, box.size.y * .5f);
-			nvgLineTo(args.vg, x1, y1);
-			nvgLineTo(args.vg, x2, y2);
+			for (int k = 0; k < d.links; k++)
+				nvgLineTo(args.vg,
+					(d.x[c][k] * .25f + .5f) * box.size.y,
+					(-d.y[c][k] * .25f + .5f) * box.size.y);
 			nvgStroke(args.vg);
 
 			nvgBeginPath(args.vg);
-			nvgCircle(args.vg, x1, y1, 1.f);
-			nvgFill(args.vg);
-			nvgBeginPath(args.vg);
-			nvgCircle(args.vg, x2, y2, 1.f);
+			for (int k = 0; k < d.links; k++)
+				nvgCircle(args.vg,
+					(d.x[c][k] * .25f + .5f) * box.size.y,
+					(-d.y[c][k] * .25f + .5f) * box.size.y, 1.f);
 			nvgFill(args.vg);
 		}
 	}
@@ -102,4 +146,37 @@ void SjoegeleWidget::appendContextMenu(Menu* menu) {
 	menu->addChild(createBoolPtrMenuItem(
 		"x\u2082 y\u2082 relative", "",
 		&module->x2y2Relative));
+
+	menu->addChild(createBoolPtrMenuItem(
+		"Show trail", "",
+		&module->showTrail));
+
+	menu->addChild(createIndexSubmenuItem(
+		"Pendulum",
+		{ "Double",
+			"Chain of 3",
+			"Chain of 4",
+			"Chain of 5",
+			"Chain of 6",
+			"Chain of 7",
+			"Chain of 8" },
+		[=]() { return module->links - 2; },
+		[=](int i) { module->links = i + 2; }));
+
+	menu->addChild(createIndexPtrSubmenuItem(
+		"Integrator",
+		{ "Semi-implicit Euler",
+			"Runge-Kutta (RK4)" },
+		&module->integrator));
+
+	menu->addChild(createIndexPtrSubmenuItem(
+		"Simulation rate",
+		{ "Audio rate",
+			"¼ audio rate",
+			"¹⁄₁₆ audio rate" },
+		&module->simRate));
+
+#ifdef VANTIES_PROFILE
+	appendProfilerMenu(menu, &module->profiler);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "AdControl.h"
+#include <algorithm>
+#include <cmath>
+#include "FastMath.h"
+
+using namespace std;
+
+namespace AdControl {
+
+void getJob(const Inputs& in, Spectrum::StereoMode stereoMode, Job& job) {
+  // Add the CV values to the knob values.
+  float partials = in.partials + .7f * in.partialsAtt * in.partialsCv;
+  float tilt = in.tilt + .2f * in.tiltAtt * in.tiltCv;
+  float sieve = in.sieve + .2f * in.sieveAtt * in.sieveCv;
+  float cvBufferDelay = in.cvBufferDelay + .1f * in.cvBufferDelayCv;
+
+  // Map 'lowest' to 'tilt' and 'lowest'.
+  float lowest = 1.f;
+  if (tilt >= 0.f) {
+    // exponential mapping for lowest
+    lowest = FastMath::exp2(tilt * 6.f);
+    tilt = 0.f;
+  } else {
+    tilt = max(tilt, -1.f);
+    tilt = tilt / (1.f + tilt);
+  }
+
+  // exponential mapping for partials
+  partials = FastMath::exp2(partials);
+  job.lowest = lowest;
+  job.highest = lowest + partials;
+  job.tilt = tilt;
+
+  if (sieve > 0.f) {
+    job.keepPrimes = true;
+    // Map sieve -> a*2^(b*sieve)+c, such that:
+    // 0->0, .4->1 and 1->5.001 (because prime[4]=11,
+    // and a .001 just to be on the safe side)
+    sieve = .876713f * FastMath::exp2(2.74508f * sieve) - 0.876713f;
+    sieve = min(max(sieve, 0.f), 5.f);
+  } else {
+    job.keepPrimes = false;
+    // the same thing, but with the reversed order of the primes
+    // map sieve: 0->31, -.8->2, -1->.999 (because prime[30]=127)
+    sieve = 31.0238f * FastMath::exp2(4.92282f * sieve) - 0.0237689f;
+    sieve = min(max(sieve, 0.f), 31.f);
+  }
+  job.sieve = sieve;
+
+  job.cvBufferOn = in.cvBufferPatched;
+  job.clocked = in.clockPatched;
+  job.clockTrigger = job.clocked && in.clock > 2.5f;
+  job.frozen = abs(cvBufferDelay) > .95f;
+  job.comb = cvBufferDelay;
+  // exponential mapping
+  job.cvBufferDelay = (job.frozen) ? 0.f :
+    (FastMath::pow10<FastMath::MEDIUM>(cvBufferDelay / .95f) - 1.f) / 9.f;
+  job.cvBufferIn = .1f * in.cvBuffer;
+
+  job.stereoMode = stereoMode;
+}
+
+void runJob(const Job& job, Spectrum& spec, CvBuffer& buf) {
+  if (job.randomize)
+    buf.randomize();
+  if (job.empty) {
+    buf.empty();
+    spec.set0();
+  }
+
+  buf.setLowestHighest(job.lowest, job.highest);
+  spec.setLowestHighest(job.lowest, job.highest);
+  spec.setTilt(job.tilt);
+  spec.setKeepPrimes(job.keepPrimes);
+  spec.setSieve(job.sieve);
+
+  if (job.cvBufferOn) {
+    buf.setOn(true);
+    spec.setComb(0.f);
+
+    buf.setClocked(job.clocked);
+    if (job.clocked)
+      buf.setClockTrigger(job.clockTrigger);
+
+    if (job.frozen)
+      buf.setFrozen(true);
+    else {
+      buf.setFrozen(false);
+      buf.setDelayRel(job.cvBufferDelay);
+      buf.push(job.cvBufferIn);
+    }
+    buf.process();
+  } else {
+    buf.setOn(false);
+    spec.setComb(job.comb);
+  }
+
+  spec.setStereoMode(job.stereoMode);
+  spec.process();
+}
+
+// We spread the phases evenly over the block, in bit-reversed order of the
+// voices (0, 8, 4, 12, 2, ...) / 16, so that they are also spread evenly when
+// only a few voices are playing.
+int getBlockPhase(int c, int blockSize) {
+  int reversed = ((c & 1) << 3) | ((c & 2) << 1) | ((c & 4) >> 1)
+    | ((c & 8) >> 3);
+  return reversed * blockSize / 16;
+}
+
+bool Voice::reset(bool set0) {
+  if (isReset)
+    return false;
+  pendingRandomize = true;
+  if (set0)
+    pendingEmpty = true;
+  isReset = true;
+  isRandomized = true;
+  return true;
+}
+
+bool Voice::checkSilence(bool ampsAre0) {
+  if (!ampsAre0) {
+    isRandomized = false;
+    return false;
+  }
+  if (isRandomized)
+    return false;
+  pendingRandomize = true;
+  isRandomized = true;
+  return true;
+}
+
+int Voice::getFundMult(int lowest, float stretch) {
+  if (lowest != fundMultLowest || stretch != fundMultStretch
+    || fundMult == 0) {
+    fundMultLowest = lowest;
+    fundMultStretch = stretch;
+    fundMult = 1;
+    do
+      fundMult *= 2;
+    while (fundMult <= abs(1.f + (fundMultLowest - 1) * fundMultStretch));
+    fundMult /= 2;
+  }
+  return fundMult;
+}
+
+} // namespace AdControl
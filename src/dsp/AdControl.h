@@ -0,0 +1,126 @@
+#pragma once
+#include "Spectrum.h"
+#include "CvBuffer.h"
+
+// the control logic of a voice of Ad, in one place for the module (Ad.cpp)
+// and the offline renderer (render/ad.cpp), so that the two can't drift apart
+// The module reads the knobs and inputs into Inputs, getJob() maps them to a
+// Job, and runJob() does the control work of a block with it, on the audio
+// thread or on Ad's worker. Voice keeps track of the resets, the sleeping
+// and the transposition of the fundamental output.
+namespace AdControl {
+
+// the knobs, and the voltages of the inputs of a voice, which the control
+// work of a block starts from
+struct Inputs {
+  float partials;
+  float tilt;
+  float sieve;
+  float cvBufferDelay;
+  float partialsAtt;
+  float tiltAtt;
+  float sieveAtt;
+  float partialsCv;
+  float tiltCv;
+  float sieveCv;
+  float cvBufferDelayCv;
+  bool cvBufferPatched;
+  float cvBuffer;
+  bool clockPatched;
+  float clock;
+};
+
+// everything the control work of a voice needs for one block
+struct Job {
+  // the voice (for Ad's worker)
+  int c = 0;
+  bool randomize = false;
+  bool empty = false;
+  float lowest;
+  float highest;
+  float tilt;
+  bool keepPrimes;
+  float sieve;
+  bool cvBufferOn;
+  bool clocked;
+  bool clockTrigger;
+  bool frozen;
+  float cvBufferDelay;
+  float cvBufferIn;
+  float comb;
+  Spectrum::StereoMode stereoMode;
+};
+
+// Map the knobs and CVs to the parameters of the spectrum and the CV buffer.
+// (c, randomize and empty are left to the caller, see Voice::getPending().)
+void getJob(const Inputs& in, Spectrum::StereoMode stereoMode, Job& job);
+// the control work of a block
+void runJob(const Job& job, Spectrum& spec, CvBuffer& buf);
+
+// The voices don't all do their block-rate work on the same sample, which
+// would make that sample a lot more expensive than the others. Voice c does
+// it on this sample of the block.
+int getBlockPhase(int c, int blockSize);
+
+// the bookkeeping of a voice around the control work
+class Voice {
+public:
+  // Reset the voice (from the button or the reset input), unless it's still
+  // reset. The CV buffer, and with set0 the spectrum, are reset with the next
+  // job. Returns whether the caller should reset its oscillators (and with
+  // set0 its spectrum).
+  bool reset(bool set0);
+  // the end of a reset signal
+  void release() { isReset = false; }
+  bool isResetting() { return isReset; }
+
+  // the resets waiting for the next job, and when the job has been run
+  void getPending(Job& job) {
+    job.randomize = pendingRandomize;
+    job.empty = pendingEmpty;
+  }
+  void jobDone() {
+    pendingRandomize = false;
+    pendingEmpty = false;
+  }
+
+  // Once the amplitudes have gone to 0, the oscillators start over and the
+  // CV buffer is randomized with the next job. Returns whether the caller
+  // should reset its oscillators.
+  bool checkSilence(bool ampsAre0);
+
+  // A voice with a silent spectrum sleeps: its oscillators don't run. When
+  // it wakes up, they catch up on their phases, as if they had been running
+  // all the time. sleep() is for every sample the voice sleeps, and returns
+  // the number of samples to skip (only at the voice's block phase, which
+  // keeps the count small); wake() returns the samples left to skip.
+  int sleep(bool atBlockPhase) {
+    sleepSamples++;
+    return (atBlockPhase) ? wake() : 0;
+  }
+  int wake() {
+    int samples = sleepSamples;
+    sleepSamples = 0;
+    return samples;
+  }
+
+  // The fundamental output plays the lowest partial, transposed down by
+  // octaves to be at most the pitch of the fundamental, so its frequency is
+  // this times the pitch. (Only recomputed when the lowest partial or the
+  // stretch change.)
+  int getFundMult(int lowest, float stretch);
+
+private:
+  // a reset of the CV buffer (and of the spectrum) waiting for the next
+  // job, where it is done together with the rest of the control work
+  bool pendingRandomize = false;
+  bool pendingEmpty = false;
+  bool isReset = false;
+  bool isRandomized = false;
+  int sleepSamples = 0;
+  int fundMult = 0;
+  int fundMultLowest = 0;
+  float fundMultStretch = 0.f;
+};
+
+} // namespace AdControl
@@ -50,12 +50,85 @@ float AdditiveOscillator::quantStretch
   return stretch;
 }
 
+int AdditiveOscillator::getHighest(double dPh) {
+  dPh = abs(dPh);
+  return (abs(stretch) > 1.e-6f) ?
+    min(spec->getHighest(),
+      (int)floorf((.5f / dPh - 1.f) / abs(stretch)) + 1) :
+    ((dPh < .5) ? spec->getHighest() : 0);
+}
+
 void AdditiveOscillator::process() {
+  // With an integer stretch, the waveform is periodic in ph[0]: partial i is
+  // sin(2*pi*(ph[0] + i*ph[2])) (see sum() below), and ph[2] is
+  // stretch*ph[0] plus an offset, which only changes with the stretch or on
+  // a reset. So once the spectrum holds still, we can render it into the
+  // table and play it from there, as long as nothing changes.
+  double offset = ph[2] - stretch * ph[0];
+  offset -= floor(offset);
+  // When the phases jump, so does the sound, so then we switch to the sines
+  // right away. (For oscillator sync, e.g.)
+  if ((source >= 0 || fade < 1.f) && !table.isInPhase(stretch, offset)) {
+    source = -1;
+    fade = 1.f;
+  }
+
+  // what we'd like to play
+  int next = -1;
+  if (periodic && spec->isSettled()) {
+    if (dPh[0] != levelDPh || spec->getHighest() != levelSpecHighest
+      || stretch != levelStretch) {
+      levelDPh = dPh[0];
+      levelSpecHighest = spec->getHighest();
+      levelStretch = stretch;
+      highest = getHighest(dPh[0]);
+      // partial i is harmonic 1 + i*stretch
+      float harmonic = (highest > 0) ? 1.f + (highest - 1) * abs(stretch) : 0.f;
+      level = AdditiveWavetable::getLevel(dPh[0], harmonic);
+    }
+    bool matches = table.matches(spec, stretch, offset);
+    // (We only start over when we aren't reading from the table.)
+    if (!matches && source < 0 && fade >= 1.f) {
+      table.clear(spec, stretch, offset);
+      matches = true;
+    }
+    if (level >= 0 && matches) {
+      next = level;
+      // While the level is being rendered, we keep on summing the sines.
+      if (!table.isReady(level, highest)) {
+        // (not while we're still reading it, though)
+        if (level != source && !(fade < 1.f && level == prevSource))
+          table.render(level, highest, spec);
+        next = -1;
+      }
+    }
+  }
+
+  if (next != source && fade >= 1.f) {
+    prevSource = source;
+    source = next;
+    fade = 0.f;
+  }
+  sum(source, wave);
+  if (fade < 1.f) {
+    float prevWave[2];
+    sum(prevSource, prevWave);
+    for (int w = 0; w < 2; w++)
+      wave[w] = prevWave[w] + fade * (wave[w] - prevWave[w]);
+    fade += FADE_STEP;
+  }
+
+  incrementPhases();
+}
+
+void AdditiveOscillator::sum(int source, float* wave) {
+  if (source >= 0) {
+    table.read(source, ph[0], wave);
+    return;
+  }
+
   // exclude partials oscillating faster than the Nyquist frequency
-  int highest = (abs(stretch) > 1.e-6f) ?
-    min(spec->getHighest(),
-      (int)floorf((.5f / abs(dPh[0]) - 1.f) / abs(stretch)) + 1) :
-    ((dPh[0] < .5) ? spec->getHighest() : 0);
+  int highest = getHighest(dPh[0]);
 
   // We compute the waves in a smarter way than computing a bunch of
   // sines bute force.
@@ -73,19 +146,15 @@ void AdditiveOscillator::process() {
   // We have 3 independent trigonometric functions, so we have 3
   // intependant phasors: ph[0] := ph,
   // ph[1] := (1+stretch)*ph and ph[2] := stretch*ph .
-  float cosine = cosf(TWOPI * ph[2]);
-  float sine_iMin2 = (highest > 0) ? sinf(TWOPI * ph[0]) : 0.f;
-  float sine_iMin1 = (highest > 1) ? sinf(TWOPI * ph[1]) : 0.f;
-  wave[0] = spec->getAmp(0, 0) * sine_iMin2 + spec->getAmp(1, 0) * sine_iMin1;
-  wave[1] = spec->getAmp(0, 1) * sine_iMin2 + spec->getAmp(1, 1) * sine_iMin1;
-  for (int i = 2; i < highest; i++) {
-    float sine_i = 2.f * sine_iMin1 * cosine - sine_iMin2;
-    wave[0] += spec->getAmp(i, 0) * sine_i;
-    wave[1] += spec->getAmp(i, 1) * sine_i;
-    sine_iMin2 = sine_iMin1;
-    sine_iMin1 = sine_i;
-  }
-
-  incrementPhases();
+  // The loop over the partials is one of the DSP kernels (see DspKernels.h),
+  // which does several partials at a time.
+  float cosine = FastMath::cos2pi(ph[2]);
+  float sine0 = (highest > 0) ? FastMath::sin2pi(ph[0]) : 0.f;
+  float sine1 = (highest > 1) ? FastMath::sin2pi(ph[1]) : 0.f;
+  // In MONO stereo mode, the spectrum only has the first channel.
+  int waves = (spec->getStereoMode() == Spectrum::MONO) ? 1 : 2;
+  dspKernels->additive(highest, sine0, sine1, cosine, spec->getAmps(),
+    spec->getOscs(), waves, wave);
+  if (waves == 1)
+    wave[1] = wave[0];
 }
-
@@ -1,6 +1,9 @@
 #pragma once
 #include "Oscillator.h"
 #include "Spectrum.h"
+#include "AdditiveWavetable.h"
+#include "FastMath.h"
+#include "DspKernels.h"
 
 // a class for the additive oscillator
 // We need 3 phasors. In the "process" method we'll see why.
@@ -26,16 +29,52 @@ public:
     dPh[1] = dPh[0] + dPh[2];
   }
 
+  // (The quantization is only evaluated when the stretch or the quantization
+  // mode change.)
   inline void setStretch(float stretch, StretchQuant stretchQuant) {
+    if (stretch == stretchIn && stretchQuant == this->stretchQuant)
+      return;
+    stretchIn = stretch;
+    this->stretchQuant = stretchQuant;
     this->stretch = quantStretch(stretch, stretchQuant);
+    periodic = this->stretch == roundf(this->stretch);
   }
 
   float getStretch() { return stretch; }
 
+  // In MONO stereo mode, the spectrum only has the amplitudes of the first
+  // channel, and we only compute one wave, which we copy to the other.
+  // When the stretch is an integer and the spectrum has settled, we play
+  // the waveform from a wavetable instead (see AdditiveWavetable.h).
   void process() override;
 
 private:
-  float stretch;
+  float stretch = 0.f;
+  // the last arguments of setStretch()
+  float stretchIn = NAN;
+  StretchQuant stretchQuant = CONTINUOUS;
 
   Spectrum* spec = nullptr;
+
+  AdditiveWavetable table;
+  // whether the stretch is an integer
+  bool periodic = false;
+  // what we play: a level of the table, or -1 for the sum of the sines
+  // When that changes, we crossfade from the previous one in 64 samples.
+  int source = -1;
+  int prevSource = -1;
+  float fade = 1.f;
+  static constexpr float FADE_STEP = 1.f / 64.f;
+  // the level and the number of partials for the frequency, which we only
+  // recompute when the frequency (or the spectrum's highest partial, or the
+  // stretch) changes
+  double levelDPh = NAN;
+  int levelSpecHighest = 0;
+  float levelStretch = NAN;
+  int level = -1;
+  int highest = 0;
+
+  // the number of partials below the Nyquist frequency
+  int getHighest(double dPh);
+  void sum(int source, float* wave);
 };
@@ -0,0 +1,78 @@
+#include "AdditiveWavetable.h"
+#include "FastMath.h"
+#include "DspKernels.h"
+
+using namespace std;
+
+int AdditiveWavetable::getLevel(double dPh, float harmonic) {
+  dPh = abs(dPh);
+  if (dPh >= 1. / 16.)
+    return -1;
+  // (This is called every sample, so no logarithms.)
+  int level = 0;
+  double bottom = 1. / 32.;
+  while (dPh < bottom && level < LEVELS - 1) {
+    bottom *= .5;
+    level++;
+  }
+  // at least 8 samples per period of the highest harmonic
+  // (This only fails on the last level, see above.)
+  if (8.f * harmonic > getSize(level))
+    return -1;
+  return level;
+}
+
+void AdditiveWavetable::clear(Spectrum* spec, float stretch, double offset) {
+  for (int k = 0; k < LEVELS; k++) {
+    ready[k] = false;
+    rendered[k] = 0;
+  }
+  version = spec->getVersion();
+  this->stretch = stretch;
+  this->offset = offset;
+}
+
+// Sample j of a level is the sum of the partials at phase j / size, like
+// AdditiveOscillator::process() computes it with the phases
+// ph[0] = j / size, ph[1] = ph[0] + ph[2] and ph[2] = stretch * ph[0] + offset.
+void AdditiveWavetable::render(int level, int highest, Spectrum* spec) {
+  if (highest != this->highest[level]) {
+    ready[level] = false;
+    rendered[level] = 0;
+    this->highest[level] = highest;
+  }
+  if (ready[level])
+    return;
+  int size = getSize(level);
+  float* y[2] = {
+    table[0] + getStart(level),
+    table[1] + getStart(level)
+  };
+  int waves = (spec->getStereoMode() == Spectrum::MONO) ? 1 : 2;
+  int end = min(rendered[level] + RENDER_STEP, size);
+  for (int j = rendered[level]; j < end; j++) {
+    double ph0 = (double)j / size;
+    double ph2 = stretch * ph0 + offset;
+    ph2 -= floor(ph2);
+    double ph1 = ph0 + ph2;
+    ph1 -= floor(ph1);
+    float wave[2];
+    dspKernels->additive(highest,
+      FastMath::sin2pi((float)ph0), FastMath::sin2pi((float)ph1),
+      FastMath::cos2pi((float)ph2), spec->getAmps(), spec->getOscs(), waves,
+      wave);
+    y[0][j + 1] = wave[0];
+    y[1][j + 1] = (waves == 1) ? wave[0] : wave[1];
+  }
+  rendered[level] = end;
+
+  if (end == size) {
+    // wrap around
+    for (int w = 0; w < 2; w++) {
+      y[w][0] = y[w][size];
+      y[w][size + 1] = y[w][1];
+      y[w][size + 2] = y[w][2];
+    }
+    ready[level] = true;
+  }
+}
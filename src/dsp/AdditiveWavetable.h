@@ -0,0 +1,98 @@
+#pragma once
+#include <cmath>
+#include "Spectrum.h"
+
+// single cycles of the waveform of an AdditiveOscillator, for when its
+// spectrum holds still and its stretch is an integer, so that the waveform is
+// periodic: the sum of the partials at a phase is then a table read
+// There's a table per octave of the frequency (a mipmap): level k is for
+// phase increments from 2^-(k+5) up to 2^-(k+4), except for the last level,
+// which is for everything below. Below the Nyquist frequency there are less
+// than 2^(k+4) harmonics then, and a level has 2^(k+7) samples, so at least 8
+// samples per period, which we read with cubic interpolation. (Its error for
+// a sine at 8 samples per period is -41 dB, at 16 -60 dB.) On the last level
+// the highest harmonic isn't bounded by the Nyquist frequency, but by the
+// number of partials and the stretch, so if it would get fewer than 8
+// samples per period there, the oscillator sums the sines instead. Above
+// 2^-4 (3 kHz at 48 kHz) there are at most 7 harmonics, which the oscillator
+// might as well compute.
+// A level has the same partials as the oscillator would sum (the ones below
+// the Nyquist frequency at the frequency it was rendered for), so switching
+// between the two doesn't change the sound. When that number of partials
+// changes, the level is rendered again.
+// The levels are rendered when they're needed, a few samples per call of
+// render(), so that it doesn't cost a lot at once.
+class AdditiveWavetable {
+public:
+  static constexpr int LEVELS = 6;
+  // the number of samples per call of render()
+  static constexpr int RENDER_STEP = 2;
+
+  // the level for the phase increment dPh and the highest harmonic, or -1 if
+  // either is too high
+  static int getLevel(double dPh, float harmonic);
+
+  // Are the tables for this stretch, with this phase offset between the
+  // partials (see AdditiveOscillator::process())?
+  // (offset in [0, 1))
+  inline bool isInPhase(float stretch, double offset) {
+    double d = fabs(offset - this->offset);
+    return stretch == this->stretch && (d < 1.e-6 || d > 1. - 1.e-6);
+  }
+  // ... and for this spectrum?
+  inline bool matches(Spectrum* spec, float stretch, double offset) {
+    return spec->getVersion() == version && isInPhase(stretch, offset);
+  }
+  // Forget the tables and start over for this spectrum, stretch and offset.
+  // (Not while a level is being read.)
+  void clear(Spectrum* spec, float stretch, double offset);
+
+  // Does the level have the partials up to highest?
+  inline bool isReady(int level, int highest) {
+    return ready[level] && this->highest[level] == highest;
+  }
+  // Render the next RENDER_STEP samples of the level, with the partials up to
+  // highest, until it's ready. If it had other partials, we start over.
+  // (Not while the level is being read.)
+  void render(int level, int highest, Spectrum* spec);
+
+  // the waveforms at phase ph, read from a ready level
+  inline void read(int level, double ph, float* wave) {
+    int size = getSize(level);
+    double x = ph * size;
+    double xFloor = floor(x);
+    float f = x - xFloor;
+    // (ph can be a hair out of [0, 1) after a wrap)
+    int i = (int)xFloor & (size - 1);
+    for (int w = 0; w < 2; w++) {
+      // table[w][j + 1] is sample j, see render()
+      const float* y = table[w] + getStart(level) + i;
+      // Catmull-Rom spline
+      float c1 = .5f * (y[2] - y[0]);
+      float c2 = y[0] - 2.5f * y[1] + 2.f * y[2] - .5f * y[3];
+      float c3 = .5f * (y[3] - y[0]) + 1.5f * (y[1] - y[2]);
+      wave[w] = ((c3 * f + c2) * f + c1) * f + y[1];
+    }
+  }
+
+private:
+  static constexpr int getSize(int level) { return 128 << level; }
+  // A level has 3 more samples than its size, for the interpolation around
+  // the ends.
+  static constexpr int getStart(int level) {
+    return 128 * ((1 << level) - 1) + 3 * level;
+  }
+  static constexpr int TABLE_SIZE = 128 * ((1 << LEVELS) - 1) + 3 * LEVELS;
+
+  float table[2][TABLE_SIZE];
+  bool ready[LEVELS] = {};
+  // the number of samples rendered so far, per level
+  int rendered[LEVELS] = {};
+  // the number of partials, per level
+  int highest[LEVELS] = {};
+
+  // what the tables are for
+  unsigned version = 0;
+  float stretch = NAN;
+  double offset = 0.;
+};
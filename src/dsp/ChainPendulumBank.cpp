@@ -0,0 +1,205 @@
+#include "ChainPendulumBank.h"
+#include "FastMath.h"
+
+using namespace std;
+
+ChainPendulumBank::ChainPendulumBank() {
+  for (int c = 0; c < SIZE; c++) {
+    l[c] = 1.f;
+    g[c] = 9.8f;
+    cof[c] = 0.f;
+    for (int k = 0; k < MAX_LINKS; k++)
+      thIs0_[k][c] = 0.f;
+    init(c);
+  }
+}
+
+void ChainPendulumBank::init(int c, float th) {
+  for (int k = 0; k < MAX_LINKS; k++) {
+    this->th[k][c] = th + 1.e-2 * (rng.uniform() - .5f);
+    dTh[k][c] = 0.f;
+    x[k][c] = FastMath::sin(this->th[k][c]);
+    y[k][c] = -FastMath::cos(this->th[k][c]);
+  }
+}
+
+void ChainPendulumBank::setPositions() {
+  for (int k = 0; k < links; k++) {
+    for (int c = 0; c < size; c++) {
+      x[k][c] = FastMath::sin(th[k][c]);
+      y[k][c] = -FastMath::cos(th[k][c]);
+    }
+  }
+}
+
+// Let u_k = (sin th_k, -cos th_k) be the direction of link k and T_k the
+// tension in it, per unit of mass and length. Mass k feels gravity,
+// -T_k * u_k and T_(k+1) * u_(k+1). Differentiating the constraints
+// u_k . (p_k - p_(k-1)) = l twice, we get a tridiagonal system for the
+// tensions:
+//   T_0 - cos(th_1 - th_0) T_1 = dTh_0^2 + g / l * cos th_0 ,
+//   -cos(th_k - th_(k-1)) T_(k-1) + 2 T_k - cos(th_(k+1) - th_k) T_(k+1)
+//     = dTh_k^2 ,
+// with T_links = 0, which we solve with the Thomas algorithm. (The matrix is
+// positive definite, so this needs no pivoting.) The components of the
+// forces perpendicular to the links then give the angular accelerations:
+//   ddTh_0 = -g / l * sin th_0 + sin(th_1 - th_0) T_1 ,
+//   ddTh_k = sin(th_(k+1) - th_k) T_(k+1) - sin(th_k - th_(k-1)) T_(k-1) .
+void ChainPendulumBank::accel(const float (* __restrict th)[SIZE],
+  const float (* __restrict dTh)[SIZE],
+  float (* __restrict ddTh)[SIZE]) {
+  // the cosines and sines of the angles between consecutive links
+  float cosDiff[MAX_LINKS][SIZE], sinDiff[MAX_LINKS][SIZE];
+  // the modified super-diagonal and right hand side of the Thomas algorithm,
+  // and then the tensions
+  float super[MAX_LINKS][SIZE], t[MAX_LINKS][SIZE];
+
+  float gl[SIZE];
+  for (int c = 0; c < size; c++)
+    gl[c] = g[c] / l[c];
+
+  for (int k = 0; k < links - 1; k++) {
+    for (int c = 0; c < size; c++) {
+      float diff = th[k + 1][c] - th[k][c];
+      cosDiff[k][c] = FastMath::cos(diff);
+      sinDiff[k][c] = FastMath::sin(diff);
+    }
+  }
+  // The last link has nothing hanging from it.
+  for (int c = 0; c < size; c++) {
+    cosDiff[links - 1][c] = 0.f;
+    sinDiff[links - 1][c] = 0.f;
+  }
+
+  // forward elimination
+  for (int c = 0; c < size; c++) {
+    super[0][c] = -cosDiff[0][c];
+    t[0][c] = dTh[0][c] * dTh[0][c] + gl[c] * FastMath::cos(th[0][c]);
+  }
+  for (int k = 1; k < links; k++) {
+    for (int c = 0; c < size; c++) {
+      float sub = -cosDiff[k - 1][c];
+      float mInv = 1.f / (2.f - sub * super[k - 1][c]);
+      super[k][c] = -cosDiff[k][c] * mInv;
+      t[k][c] = (dTh[k][c] * dTh[k][c] - sub * t[k - 1][c]) * mInv;
+    }
+  }
+  // back substitution
+  for (int k = links - 2; k >= 0; k--) {
+    for (int c = 0; c < size; c++)
+      t[k][c] -= super[k][c] * t[k + 1][c];
+  }
+
+  // The friction is scaled with the sample time, like in DoublePendulumBank.
+  for (int k = 0; k < links; k++) {
+    for (int c = 0; c < size; c++)
+      ddTh[k][c] = -cof[c] * dTh[k][c] * sampleTime;
+  }
+  for (int c = 0; c < size; c++)
+    ddTh[0][c] -= gl[c] * FastMath::sin(th[0][c]);
+  for (int k = 0; k < links - 1; k++) {
+    for (int c = 0; c < size; c++) {
+      ddTh[k][c] += sinDiff[k][c] * t[k + 1][c];
+      ddTh[k + 1][c] -= sinDiff[k][c] * t[k][c];
+    }
+  }
+}
+
+// a single step of the integrator, of dt seconds, for all the pendulums
+void ChainPendulumBank::step(float dt) {
+  float thPrev[MAX_LINKS][SIZE], dThPrev[MAX_LINKS][SIZE];
+  for (int k = 0; k < links; k++) {
+    for (int c = 0; c < size; c++) {
+      thPrev[k][c] = th[k][c];
+      dThPrev[k][c] = dTh[k][c];
+    }
+  }
+
+  if (integrator == DoublePendulumBank::RK4) {
+    // the velocities and accelerations in the four stages, and the
+    // intermediate angles
+    float w[4][MAX_LINKS][SIZE], a[4][MAX_LINKS][SIZE];
+    float t[MAX_LINKS][SIZE];
+    const float stage[4] = { 0.f, .5f * dt, .5f * dt, dt };
+    for (int s = 0; s < 4; s++) {
+      float h = stage[s];
+      for (int k = 0; k < links; k++) {
+        if (s == 0) {
+          for (int c = 0; c < size; c++) {
+            w[0][k][c] = dTh[k][c];
+            t[k][c] = th[k][c];
+          }
+        } else {
+          for (int c = 0; c < size; c++) {
+            w[s][k][c] = dTh[k][c] + h * a[s - 1][k][c];
+            t[k][c] = th[k][c] + h * w[s - 1][k][c];
+          }
+        }
+      }
+      accel(t, w[s], a[s]);
+    }
+
+    float dt6 = dt / 6.f;
+    for (int k = 0; k < links; k++) {
+      for (int c = 0; c < size; c++) {
+        th[k][c] += dt6
+          * (w[0][k][c] + 2.f * (w[1][k][c] + w[2][k][c]) + w[3][k][c]);
+        dTh[k][c] += dt6
+          * (a[0][k][c] + 2.f * (a[1][k][c] + a[2][k][c]) + a[3][k][c]);
+      }
+    }
+  } else {
+    // semi-implicit (symplectic) Euler
+    float a[MAX_LINKS][SIZE];
+    accel(th, dTh, a);
+    for (int k = 0; k < links; k++) {
+      for (int c = 0; c < size; c++) {
+        dTh[k][c] += a[k][c] * dt;
+        th[k][c] += dTh[k][c] * dt;
+      }
+    }
+  }
+
+  // the same safeguard and gates as in DoublePendulumBank
+  for (int k = 0; k < links; k++) {
+    for (int c = 0; c < size; c++) {
+      dTh[k][c] = (abs(dTh[k][c]) <= maxDTh) ? dTh[k][c] : 0.f;
+      th[k][c] -= floorf(th[k][c] * TWOPI_INV) * TWOPI;
+      thIs0_[k][c] = (abs(th[k][c] - thPrev[k][c]) > (float)M_PI) ? 1.f :
+        ((dThPrev[k][c] * dTh[k][c] < 0.f)
+          | ((thPrev[k][c] - (float)M_PI) * (th[k][c] - (float)M_PI) < 0.f)) ?
+        0.f : thIs0_[k][c];
+    }
+  }
+
+  // (not vectorized, but this hardly ever happens)
+  for (int c = 0; c < size; c++) {
+    bool finite = true;
+    for (int k = 0; k < links; k++)
+      finite = finite && isfinite(th[k][c]);
+    if (!finite)
+      init(c);
+  }
+}
+
+void ChainPendulumBank::process(float dt) {
+  // Like in DoublePendulumBank, but the highest natural frequency of a chain
+  // is about 1.7 sqrt(links * g / l) (for 8 links).
+  float speed = 0.f;
+  for (int c = 0; c < channels; c++) {
+    float s = 2.f * sqrtf(links * abs(g[c]) / l[c]);
+    for (int k = 0; k < links; k++)
+      s += abs(dTh[k][c]);
+    speed = fmaxf(speed, s);
+  }
+  float maxStepAngle = (integrator == DoublePendulumBank::RK4) ?
+    MAX_STEP_ANGLE_RK4 :
+    MAX_STEP_ANGLE_EULER;
+  int steps = min(max((int)ceilf(speed * dt / maxStepAngle), 1),
+    MAX_SUBSTEPS);
+  float h = dt / steps;
+  for (int i = 0; i < steps; i++)
+    step(h);
+
+  setPositions();
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include "Random.h"
+#include "DoublePendulumBank.h"
+
+// a bank of up to 16 chain pendulums with 3 to 8 links, simulated side by
+// side like in DoublePendulumBank
+// Each link is a massless rod of length l with a unit point mass at its end.
+// Instead of inverting the dense mass matrix of the angles, we solve for the
+// tensions in the rods, which are given by a tridiagonal system (see
+// accel()), so the cost grows linearly with the number of links.
+class ChainPendulumBank {
+public:
+  static constexpr int SIZE = 16;
+  static constexpr int MIN_LINKS = 3;
+  static constexpr int MAX_LINKS = 8;
+  static constexpr float TWOPI = 2.f * M_PI;
+  static constexpr float TWOPI_INV = 1.f / TWOPI;
+
+  typedef DoublePendulumBank::Integrator Integrator;
+
+  static constexpr float MAX_STEP_ANGLE_EULER =
+    DoublePendulumBank::MAX_STEP_ANGLE_EULER;
+  static constexpr float MAX_STEP_ANGLE_RK4 =
+    DoublePendulumBank::MAX_STEP_ANGLE_RK4;
+  static constexpr int MAX_SUBSTEPS = DoublePendulumBank::MAX_SUBSTEPS;
+
+private:
+  Integrator integrator = DoublePendulumBank::RK4;
+  float maxDTh = 0.f;
+  float sampleTime = 0.f;
+  int links = MIN_LINKS;
+  // the number of pendulums we simulate, a multiple of 4, of which the first
+  // channels are in use (the others are padding, with whatever state the
+  // voices that used them left behind)
+  int size = SIZE;
+  int channels = SIZE;
+
+  // the angles and angular velocities of the links, absolute, i.e. with
+  // respect to the vertical
+  float th[MAX_LINKS][SIZE];
+  float dTh[MAX_LINKS][SIZE];
+  // the positions of the ends of the links, relative to their beginnings
+  float x[MAX_LINKS][SIZE];
+  float y[MAX_LINKS][SIZE];
+  float l[SIZE];
+  float g[SIZE];
+  float cof[SIZE];
+  Random rng;
+  // the gates, as 0. or 1.
+  float thIs0_[MAX_LINKS][SIZE];
+
+  // the angular accelerations in the states (th, dTh)
+  void accel(const float (* __restrict th)[SIZE],
+    const float (* __restrict dTh)[SIZE],
+    float (* __restrict ddTh)[SIZE]);
+  void step(float dt);
+  void setPositions();
+
+public:
+  ChainPendulumBank();
+
+  void setSampleRate(int sampleRate) {
+    maxDTh = .5f * M_PI * sampleRate;
+    sampleTime = 1.f / sampleRate;
+  }
+  // simulate only the first channels pendulums (rounded up to 4)
+  void setChannels(int channels) {
+    this->channels = std::min(channels, SIZE);
+    size = std::min((channels + 3) & ~3, SIZE);
+  }
+  // Changing the number of links doesn't restart the pendulums, call init()
+  // for that.
+  void setLinks(int links) {
+    this->links = std::min(std::max(links, MIN_LINKS), MAX_LINKS);
+  }
+  int getLinks() { return links; }
+
+  // the position of the end of link k, relative to its beginning
+  float getX(int c, int k) { return x[k][c]; }
+  float getY(int c, int k) { return y[k][c]; }
+  bool thIs0(int c, int k) { return thIs0_[k][c] > 0.f; }
+  float getG(int c) { return g[c]; }
+  float getL(int c) { return l[c]; }
+  float getCOF(int c) { return cof[c]; }
+
+  // all links get the angle th
+  void init(int c, float th = M_PI);
+  // for reproducible init()s, see Random
+  void seed(uint32_t seed) { rng.seed(seed); }
+  void setLength(int c, float l) { this->l[c] = l; }
+  void setGravity(int c, float g) { this->g[c] = g; }
+  void setCOF(int c, float cof) { this->cof[c] = cof; }
+  void setIntegrator(Integrator integrator) { this->integrator = integrator; }
+  // advance all the pendulums by dt seconds, in as many steps as needed
+  void process(float dt);
+};
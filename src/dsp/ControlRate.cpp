@@ -0,0 +1,18 @@
+#include "ControlRate.h"
+#include <algorithm>
+
+using namespace std;
+
+int getBlockSize(ControlRate controlRate, float sampleRate) {
+  int blockSize = 16 << controlRate;
+  return max(1, min(blockSize, (int)(blockSize * sampleRate / 48000.f)));
+}
+
+int getCvBufferSize(int blockSize, float sampleRate) {
+  return (int)(4.f * sampleRate / (float)blockSize);
+}
+
+int getMaxCvBufferSize() {
+  return getCvBufferSize(getBlockSize(CONTROL_RATE_16, MAX_SAMPLE_RATE),
+    MAX_SAMPLE_RATE);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// the rate of the control work of Ad, Adje and Bufke (the spectra and the CV
+// buffers), as a fraction of the sample rate
+enum ControlRate {
+  CONTROL_RATE_16,
+  CONTROL_RATE_32,
+  CONTROL_RATE_64,
+  CONTROL_RATE_128,
+  CONTROL_RATES_LEN
+};
+
+// the highest sample rate Rack offers
+const float MAX_SAMPLE_RATE = 768000.f;
+
+// the number of samples per block of control work: 16 << controlRate, but
+// below 48 kHz the blocks get proportionally shorter, so that the control
+// rate doesn't get lower than at 48 kHz (e.g. 750 Hz for 1/64)
+int getBlockSize(ControlRate controlRate, float sampleRate);
+// the size of a CV buffer of 4 seconds, in blocks
+int getCvBufferSize(int blockSize, float sampleRate);
+// ... and the largest one, for the highest sample and control rate, which the
+// CV buffers are allocated for, so that changing the rates doesn't allocate
+int getMaxCvBufferSize();
@@ -20,11 +20,13 @@ void CvBuffer::processClock() {
   }
 }
 
-void CvBuffer::init(int size, int oscs, Mode* mode, int maxClock) {
+void CvBuffer::init(int size, int oscs, Mode* mode, int maxClock,
+  int capacity) {
   // size is going to be time * sampleRate * blockRatio
   size = max(size, 0);
   this->size = size;
-  buf = new float[size];
+  this->capacity = max(capacity, size);
+  buf = new float[this->capacity];
   posWrite = 0;
   empty();
 
@@ -40,8 +42,8 @@ void CvBuffer::init(int size, int oscs, Mode* mode, int maxClock) {
 }
 
 CvBuffer::~CvBuffer() {
-  delete buf;
-  delete random;
+  delete[] buf;
+  delete[] random;
 }
 
 void CvBuffer::setLowestHighest(float lowest, float highest) {
@@ -66,7 +68,7 @@ void CvBuffer::empty() {
 void CvBuffer::randomize() {
   randomized = true;
   for (int i = 0; i < oscs; i++)
-    random[i] = (float)rand() / (float)RAND_MAX;
+    random[i] = rng.uniform();
 }
 
 void CvBuffer::process() {
@@ -103,9 +105,48 @@ void CvBuffer::resize(int size) {
   if (this->size == size || size < 0)
     return;
 
-  this->size = size;
-  delete buf;
-  buf = new float[size];
-  empty();
+  // Put the oldest value first.
+  int oldSize = this->size;
+  if (oldSize > 0)
+    rotate(buf, buf + posWrite, buf + oldSize);
   posWrite = 0;
+
+  if (size > capacity) {
+    float* newBuf = new float[size];
+    copy(buf, buf + oldSize, newBuf);
+    delete[] buf;
+    buf = newBuf;
+    capacity = size;
+  }
+  this->size = size;
+
+  if (oldSize <= 1 || size == 1) {
+    float value = (oldSize > 0) ? buf[oldSize - 1] : 0.f;
+    for (int j = 0; j < size; j++)
+      buf[j] = value;
+    return;
+  }
+
+  // Resample in place, with linear interpolation, from the oldest to the
+  // newest value. Value j comes from x <= j when growing, so we go down, and
+  // from x >= j when shrinking, so we go up; either way we only read values
+  // we haven't overwritten yet.
+  double ratio = (double)(oldSize - 1) / (double)(size - 1);
+  auto resample = [&](int j) {
+    double x = j * ratio;
+    int i = min((int)x, oldSize - 2);
+    float f = (float)(x - i);
+    buf[j] = buf[i] + f * (buf[i + 1] - buf[i]);
+  };
+  if (size > oldSize) {
+    for (int j = size - 1; j >= 0; j--)
+      resample(j);
+  } else {
+    for (int j = 0; j < size; j++)
+      resample(j);
+  }
+
+  // The clock counts in values (blocks) too.
+  clTime = (int)round(clTime / ratio);
+  clCounter = (int)round(clCounter / ratio);
 }
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <algorithm>
 #include <limits.h>
+#include "Random.h"
 
 // a class for the CV buffer
 class CvBuffer {
@@ -12,7 +13,10 @@ public:
     RANDOM
   };
 
-  void init(int size, int oscs, Mode* mode, int maxClock = INT_MAX);
+  // (With a capacity larger than size, resize() can grow the buffer up to it
+  // without allocating, e.g. on the audio thread.)
+  void init(int size, int oscs, Mode* mode, int maxClock = INT_MAX,
+    int capacity = 0);
 
   ~CvBuffer();
 
@@ -42,13 +46,20 @@ public:
   void push(float value);
   void empty();
   void randomize();
+  // for reproducible randomize()s, see Random
+  void seed(uint32_t seed) { rng.seed(seed); }
   virtual void process();
+  // Change the number of values, keeping the contents: they're resampled to
+  // the new size, e.g. for a new sample rate. Only allocates beyond the
+  // capacity.
   void resize(int size);
 
 protected:
-  float* buf;
+  float* buf = nullptr;
   int posWrite = 0;
   int size = 0;
+  // the number of values buf has room for
+  int capacity = 0;
   // delayRel is a float between 0. and 1.. It is the delay time relative to 
   // the maximum, given by the buffer size. 
   float delayRel = 0;
@@ -64,7 +75,8 @@ protected:
   ////  random  //////////////////////////////////////////////////////////////
 
   int oscs = 0;
-  float* random;
+  float* random = nullptr;
+  Random rng;
 
   ////  clock  ///////////////////////////////////////////////////////////////
 
@@ -0,0 +1,172 @@
+#include "DoublePendulumBank.h"
+#include <algorithm>
+#include "FastMath.h"
+
+using namespace std;
+
+DoublePendulumBank::DoublePendulumBank() {
+  for (int c = 0; c < SIZE; c++) {
+    l[c] = 1.f;
+    g[c] = 9.8f;
+    cof[c] = 0.f;
+    th1Is0_[c] = 0.f;
+    th2Is0_[c] = 0.f;
+    init(c);
+  }
+}
+
+void DoublePendulumBank::init(int c, float th1, float th2) {
+  this->th1[c] = th1 + 1.e-2 * (rng.uniform() - .5f);
+  this->th2[c] = th2 + 1.e-2 * (rng.uniform() - .5f);
+  dTh1[c] = 0.f;
+  dTh2[c] = 0.f;
+
+  x1[c] = FastMath::sin(this->th1[c]);
+  y1[c] = -FastMath::cos(this->th1[c]);
+  x2[c] = FastMath::sin(this->th2[c]);
+  y2[c] = -FastMath::cos(this->th2[c]);
+}
+
+void DoublePendulumBank::setPositions() {
+  for (int c = 0; c < size; c++) {
+    x1[c] = FastMath::sin(th1[c]);
+    y1[c] = -FastMath::cos(th1[c]);
+    x2[c] = FastMath::sin(th2[c]);
+    y2[c] = -FastMath::cos(th2[c]);
+  }
+}
+
+// (The pointers never overlap, telling the compiler so lets it vectorize
+// the loop.)
+void DoublePendulumBank::accel(
+  const float* __restrict th1, const float* __restrict th2,
+  const float* __restrict dTh1, const float* __restrict dTh2,
+  float* __restrict ddTh1, float* __restrict ddTh2) {
+  for (int c = 0; c < size; c++) {
+    float thDiff = th1[c] - th2[c];
+    float dTh1Sq = dTh1[c] * dTh1[c];
+    float dTh2Sq = dTh2[c] * dTh2[c];
+    float sinThDiff = FastMath::sin(thDiff);
+    float cosThDiff = FastMath::cos(thDiff);
+    // cos(2 thDiff) = 2 cos^2(thDiff) - 1
+    float A = 1.f / (l[c] * (4.f - 2.f * cosThDiff * cosThDiff));
+
+    // The friction is scaled with the sample time, so that the pendulums
+    // keep swinging the same way, whatever the integrator and its step size.
+    ddTh1[c] = A * (-3.f * g[c] * FastMath::sin(th1[c])
+      - g[c] * FastMath::sin(th1[c] - 2.f * th2[c])
+      - 2.f * sinThDiff * l[c] * (dTh2Sq + dTh1Sq * cosThDiff))
+      - cof[c] * dTh1[c] * sampleTime;
+    ddTh2[c] = 2.f * A * sinThDiff
+      * (2.f * dTh1Sq * l[c] + 2.f * g[c] * FastMath::cos(th1[c])
+        + dTh2Sq * l[c] * cosThDiff)
+      - cof[c] * dTh2[c] * sampleTime;
+  }
+}
+
+// a single step of the integrator, of dt seconds, for all the pendulums
+void DoublePendulumBank::step(float dt) {
+  float th1Prev[SIZE], th2Prev[SIZE], dTh1Prev[SIZE], dTh2Prev[SIZE];
+  for (int c = 0; c < size; c++) {
+    th1Prev[c] = th1[c];
+    th2Prev[c] = th2[c];
+    dTh1Prev[c] = dTh1[c];
+    dTh2Prev[c] = dTh2[c];
+  }
+
+  if (integrator == RK4) {
+    // the velocities and accelerations in the four stages, and the
+    // intermediate angles
+    float w1[4][SIZE], w2[4][SIZE], a1[4][SIZE], a2[4][SIZE];
+    float t1[SIZE], t2[SIZE];
+    const float stage[4] = { 0.f, .5f * dt, .5f * dt, dt };
+    for (int k = 0; k < 4; k++) {
+      float h = stage[k];
+      if (k == 0) {
+        for (int c = 0; c < size; c++) {
+          w1[0][c] = dTh1[c];
+          w2[0][c] = dTh2[c];
+          t1[c] = th1[c];
+          t2[c] = th2[c];
+        }
+      } else {
+        for (int c = 0; c < size; c++) {
+          w1[k][c] = dTh1[c] + h * a1[k - 1][c];
+          w2[k][c] = dTh2[c] + h * a2[k - 1][c];
+          t1[c] = th1[c] + h * w1[k - 1][c];
+          t2[c] = th2[c] + h * w2[k - 1][c];
+        }
+      }
+      accel(t1, t2, w1[k], w2[k], a1[k], a2[k]);
+    }
+
+    float dt6 = dt / 6.f;
+    for (int c = 0; c < size; c++) {
+      th1[c] += dt6 * (w1[0][c] + 2.f * (w1[1][c] + w1[2][c]) + w1[3][c]);
+      th2[c] += dt6 * (w2[0][c] + 2.f * (w2[1][c] + w2[2][c]) + w2[3][c]);
+      dTh1[c] += dt6 * (a1[0][c] + 2.f * (a1[1][c] + a1[2][c]) + a1[3][c]);
+      dTh2[c] += dt6 * (a2[0][c] + 2.f * (a2[1][c] + a2[2][c]) + a2[3][c]);
+    }
+  } else {
+    // semi-implicit (symplectic) Euler:
+    // first update the velocities, then the angles with the new velocities
+    float a1[SIZE], a2[SIZE];
+    accel(th1, th2, dTh1, dTh2, a1, a2);
+    for (int c = 0; c < size; c++) {
+      dTh1[c] += a1[c] * dt;
+      dTh2[c] += a2[c] * dt;
+      th1[c] += dTh1[c] * dt;
+      th2[c] += dTh2[c] * dt;
+    }
+  }
+
+  for (int c = 0; c < size; c++) {
+    // a last resort, if the simulation blows up anyway
+    dTh1[c] = (abs(dTh1[c]) <= maxDTh) ? dTh1[c] : 0.f;
+    dTh2[c] = (abs(dTh2[c]) <= maxDTh) ? dTh2[c] : 0.f;
+
+    th1[c] -= floorf(th1[c] * TWOPI_INV) * TWOPI;
+    th2[c] -= floorf(th2[c] * TWOPI_INV) * TWOPI;
+
+    // A step turns a pendulum by less than pi, so a jump of more than pi
+    // means that the angle has wrapped around 0: the gate goes high. It goes
+    // low when the velocity changes sign or the angle passes pi.
+    // (Sign changes are detected as negative products, which vectorizes
+    // better than comparing booleans.)
+    th1Is0_[c] = (abs(th1[c] - th1Prev[c]) > (float)M_PI) ? 1.f :
+      ((dTh1Prev[c] * dTh1[c] < 0.f)
+        | ((th1Prev[c] - (float)M_PI) * (th1[c] - (float)M_PI) < 0.f)) ?
+      0.f : th1Is0_[c];
+    th2Is0_[c] = (abs(th2[c] - th2Prev[c]) > (float)M_PI) ? 1.f :
+      ((dTh2Prev[c] * dTh2[c] < 0.f)
+        | ((th2Prev[c] - (float)M_PI) * (th2[c] - (float)M_PI) < 0.f)) ?
+      0.f : th2Is0_[c];
+  }
+
+  // (not vectorized, but this hardly ever happens)
+  for (int c = 0; c < size; c++) {
+    if (!isfinite(th1[c]) || !isfinite(th2[c]))
+      init(c);
+  }
+}
+
+void DoublePendulumBank::process(float dt) {
+  // Take enough sub-steps, so that in each of them every pendulum turns at
+  // most the maximum step angle, also for high gravity and short rods, where
+  // the natural frequency sqrt(g / l) gets high. (Only the pendulums in
+  // use count, the padding doesn't need to be accurate.)
+  float speed = 0.f;
+  for (int c = 0; c < channels; c++)
+    speed = fmaxf(speed,
+      abs(dTh1[c]) + abs(dTh2[c]) + sqrtf(abs(g[c]) / l[c]));
+  float maxStepAngle = (integrator == RK4) ?
+    MAX_STEP_ANGLE_RK4 :
+    MAX_STEP_ANGLE_EULER;
+  int steps = min(max((int)ceilf(speed * dt / maxStepAngle), 1),
+    MAX_SUBSTEPS);
+  float h = dt / steps;
+  for (int i = 0; i < steps; i++)
+    step(h);
+
+  setPositions();
+}
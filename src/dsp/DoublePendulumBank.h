@@ -0,0 +1,96 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include "Random.h"
+
+// a bank of up to 16 double pendulums, simulated side by side
+// The state is stored as a structure of arrays and all the loops run over the
+// pendulums in lockstep, without branches (also in the trigonometry, see
+// FastMath.h), so that the compiler can vectorize them: 4 pendulums per
+// instruction with SSE, 8 with AVX.
+class DoublePendulumBank {
+public:
+  static constexpr int SIZE = 16;
+  static constexpr float TWOPI = 2.f * M_PI;
+  static constexpr float TWOPI_INV = 1.f / TWOPI;
+
+  enum Integrator {
+    SEMI_IMPLICIT_EULER,
+    RK4
+  };
+
+  // the maximum angle (in radians) a pendulum may turn in a single step
+  // of the integrator, see process()
+  // (Euler is only first order, so it needs much smaller steps than RK4.)
+  static constexpr float MAX_STEP_ANGLE_EULER = .02f;
+  static constexpr float MAX_STEP_ANGLE_RK4 = .2f;
+  static constexpr int MAX_SUBSTEPS = 64;
+
+private:
+  Integrator integrator = RK4;
+  float maxDTh = 0.f;
+  float sampleTime = 0.f;
+  // the number of pendulums we simulate, a multiple of 4, of which the first
+  // channels are in use (the others are padding, with whatever state the
+  // voices that used them left behind)
+  int size = SIZE;
+  int channels = SIZE;
+
+  float th1[SIZE];
+  float th2[SIZE];
+  float dTh1[SIZE];
+  float dTh2[SIZE];
+  float x1[SIZE];
+  float y1[SIZE];
+  float x2[SIZE];
+  float y2[SIZE];
+  float l[SIZE];
+  float g[SIZE];
+  float cof[SIZE];
+  Random rng;
+  // the gates, as 0. or 1.
+  float th1Is0_[SIZE];
+  float th2Is0_[SIZE];
+
+  // the angular accelerations in the states (th1, th2, dTh1, dTh2)
+  void accel(const float* __restrict th1, const float* __restrict th2,
+    const float* __restrict dTh1, const float* __restrict dTh2,
+    float* __restrict ddTh1, float* __restrict ddTh2);
+  void step(float dt);
+  void setPositions();
+
+public:
+  DoublePendulumBank();
+
+  void setSampleRate(int sampleRate) {
+    maxDTh = .5f * M_PI * sampleRate;
+    sampleTime = 1.f / sampleRate;
+  }
+  // simulate only the first channels pendulums (rounded up to 4)
+  void setChannels(int channels) {
+    this->channels = std::min(channels, SIZE);
+    size = std::min((channels + 3) & ~3, SIZE);
+  }
+
+  float getX1(int c) { return x1[c]; }
+  float getY1(int c) { return y1[c]; }
+  float getX2Rel(int c) { return x2[c]; }
+  float getY2Rel(int c) { return y2[c]; }
+  float getX2Abs(int c) { return x1[c] + x2[c]; }
+  float getY2Abs(int c) { return y1[c] + y2[c]; }
+  bool th1Is0(int c) { return th1Is0_[c] > 0.f; }
+  bool th2Is0(int c) { return th2Is0_[c] > 0.f; }
+  float getG(int c) { return g[c]; }
+  float getL(int c) { return l[c]; }
+  float getCOF(int c) { return cof[c]; }
+
+  void init(int c, float th1 = M_PI, float th2 = M_PI);
+  // for reproducible init()s, see Random
+  void seed(uint32_t seed) { rng.seed(seed); }
+  void setLength(int c, float l) { this->l[c] = l; }
+  void setGravity(int c, float g) { this->g[c] = g; }
+  void setCOF(int c, float cof) { this->cof[c] = cof; }
+  void setIntegrator(Integrator integrator) { this->integrator = integrator; }
+  // advance all the pendulums by dt seconds, in as many steps as needed
+  void process(float dt);
+};
@@ -0,0 +1,70 @@
+#include "DspKernels.h"
+
+// defined in DspKernelsScalar.cpp, DspKernelsBaseline.cpp, etc.
+const DspKernels* getDspKernelsScalar();
+const DspKernels* getDspKernelsBaseline();
+const DspKernels* getDspKernelsAvx2();
+const DspKernels* getDspKernelsAvx512();
+
+const DspKernels* dspKernels = getDspKernelsBaseline();
+static DspKernels::Isa isa = DspKernels::BASELINE;
+
+// whether the CPU (and the OS) supports isa
+static bool supports(DspKernels::Isa isa) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (isa == DspKernels::AVX2)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  if (isa == DspKernels::AVX512)
+    return __builtin_cpu_supports("avx512f")
+      && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+  if (isa == DspKernels::AVX2 || isa == DspKernels::AVX512)
+    return false;
+#endif
+  return true;
+}
+
+const DspKernels* DspKernels::get(Isa isa) {
+  if (!supports(isa))
+    return nullptr;
+  switch (isa) {
+    case SCALAR: return getDspKernelsScalar();
+    case BASELINE: return getDspKernelsBaseline();
+    case AVX2: return getDspKernelsAvx2();
+    case AVX512: return getDspKernelsAvx512();
+    default: return nullptr;
+  }
+}
+
+const char* DspKernels::getName(Isa isa) {
+  switch (isa) {
+    case SCALAR: return "scalar";
+#if defined(__SSE4_2__)
+    case BASELINE: return "SSE4.2";
+#elif defined(__SSE2__)
+    case BASELINE: return "SSE2";
+#elif defined(__ARM_NEON)
+    case BASELINE: return "NEON";
+#else
+    case BASELINE: return "baseline";
+#endif
+    case AVX2: return "AVX2";
+    case AVX512: return "AVX-512";
+    default: return "";
+  }
+}
+
+void DspKernels::init(Isa max) {
+  for (int i = max; i >= SCALAR; i--) {
+    const DspKernels* k = get((Isa)i);
+    if (k) {
+      dspKernels = k;
+      isa = (Isa)i;
+      return;
+    }
+  }
+}
+
+DspKernels::Isa DspKernels::getIsa() {
+  return isa;
+}
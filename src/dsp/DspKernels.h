@@ -0,0 +1,41 @@
+#pragma once
+
+// the hot loops of the DSP classes, compiled for several instruction sets
+// Rack plugins are built for a baseline x64 CPU, so the compiler can't use
+// wider vectors for our loops by itself. Instead, the kernels are compiled
+// once for each instruction set below (see DspKernelsImpl.h and the
+// Makefile), and at plugin init DspKernels::init() picks the best one the CPU
+// supports. On other architectures there's only the scalar and the baseline
+// variant.
+struct DspKernels {
+  enum Isa {
+    SCALAR,
+    // whatever the plugin is built for: SSE4.2 on x64, NEON on arm64
+    BASELINE,
+    AVX2,
+    AVX512,
+    ISAS_LEN
+  };
+
+  // the sum over the partials i < highest of amps[i + w * oscs] * sine_i,
+  // for each wave w < waves, with sine_0 = sine0, sine_1 = sine1 and
+  // sine_i = 2 * cosine * sine_(i-1) - sine_(i-2), see
+  // AdditiveOscillator::process()
+  void (*additive)(int highest, float sine0, float sine1, float cosine,
+    const float* amps, int oscs, int waves, float* wave);
+  // y[i] += k * (x[i] - y[i]) for i < n
+  void (*smoothen)(float* y, const float* x, float k, int n);
+
+  // the variant for isa, or nullptr if it isn't compiled in or the CPU
+  // doesn't support it
+  static const DspKernels* get(Isa isa);
+  static const char* getName(Isa isa);
+
+  // Detect the CPU features and select the best variant, or a lower one
+  // (for comparing them).
+  static void init(Isa max = AVX512);
+  static Isa getIsa();
+};
+
+// the selected variant
+extern const DspKernels* dspKernels;
@@ -0,0 +1,13 @@
+// the AVX2 variant of the kernels, see DspKernels.h
+// (It's only compiled in on x64, with the flags of the Makefile.)
+#include "DspKernels.h"
+
+#ifdef __AVX2__
+#define DSP_KERNELS_NAMESPACE DspKernelsAvx2
+#define DSP_KERNELS_WIDTH 8
+#include "DspKernelsImpl.h"
+
+const DspKernels* getDspKernelsAvx2() { return &DspKernelsAvx2::kernels; }
+#else
+const DspKernels* getDspKernelsAvx2() { return nullptr; }
+#endif
@@ -0,0 +1,13 @@
+// the AVX-512 variant of the kernels, see DspKernels.h
+// (It's only compiled in on x64, with the flags of the Makefile.)
+#include "DspKernels.h"
+
+#ifdef __AVX512F__
+#define DSP_KERNELS_NAMESPACE DspKernelsAvx512
+#define DSP_KERNELS_WIDTH 16
+#include "DspKernelsImpl.h"
+
+const DspKernels* getDspKernelsAvx512() { return &DspKernelsAvx512::kernels; }
+#else
+const DspKernels* getDspKernelsAvx512() { return nullptr; }
+#endif
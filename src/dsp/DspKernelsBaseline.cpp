@@ -0,0 +1,7 @@
+// the variant of the kernels for the instruction set the plugin is built for
+// (SSE4.2 on x64, NEON on arm64), see DspKernels.h
+#define DSP_KERNELS_NAMESPACE DspKernelsBaseline
+#define DSP_KERNELS_WIDTH 4
+#include "DspKernelsImpl.h"
+
+const DspKernels* getDspKernelsBaseline() { return &DspKernelsBaseline::kernels; }
@@ -0,0 +1,102 @@
+// the bodies of the kernels of DspKernels.h
+// This file is included by DspKernelsScalar.cpp, DspKernelsBaseline.cpp,
+// etc., which define DSP_KERNELS_NAMESPACE and DSP_KERNELS_WIDTH, and are
+// compiled with the flags of their instruction sets (see the Makefile). The
+// kernels work on vectors of W floats, or on simple loops that the compiler
+// vectorizes by itself.
+// Don't include other headers with inline functions here: the linker might
+// pick our AVX copy of such a function for the rest of the plugin too.
+#include <cstring>
+#include "DspKernels.h"
+
+namespace DSP_KERNELS_NAMESPACE {
+
+static constexpr int W = DSP_KERNELS_WIDTH;
+// a vector of W floats (with GCC's and Clang's vector extensions), which
+// the compiler maps to the widest registers of the instruction set
+#if DSP_KERNELS_WIDTH > 1
+typedef float Vec __attribute__((vector_size(4 * W)));
+#else
+typedef float Vec;
+#endif
+
+static inline Vec load(const float* x) {
+  Vec v;
+  memcpy(&v, x, sizeof(Vec));
+  return v;
+}
+static inline void store(float* x, Vec v) {
+  memcpy(x, &v, sizeof(Vec));
+}
+
+// The recursion over the partials is inherently serial, with a latency of a
+// multiplication and a subtraction per partial. But we can just as well step
+// W partials at a time, with sin(a + 2Wb) = 2 cos(Wb) sin(a + Wb) - sin(a):
+// that's W independent recursions, one per lane of a vector.
+template <int waves>
+static void additiveWaves(int highest, float sine0, float sine1,
+  float cosine, const float* amps, int oscs, float* wave) {
+  // the first 2W sines, by the same trick: from the first 2m sines and
+  // cos(mb) we get the next 2m, and cos(2mb) = 2 cos(mb)^2 - 1
+  float sine[2 * W];
+  sine[0] = sine0;
+  sine[1] = sine1;
+  float cosW = cosine;
+  for (int m = 1; 2 * m <= W; m *= 2) {
+    for (int i = 2 * m; i < 4 * m; i++)
+      sine[i] = 2.f * cosW * sine[i - m] - sine[i - 2 * m];
+    cosW = 2.f * cosW * cosW - 1.f;
+  }
+  float twoCosW = 2.f * cosW;
+
+  Vec prev = load(sine);
+  Vec cur = load(sine + W);
+  Vec acc0 = {};
+  Vec acc1 = {};
+  const float* amps0 = amps;
+  const float* amps1 = amps + oscs;
+  int i = 0;
+  for (; i + W <= highest; i += W) {
+    acc0 += load(amps0 + i) * prev;
+    if (waves == 2)
+      acc1 += load(amps1 + i) * prev;
+    Vec next = twoCosW * cur - prev;
+    prev = cur;
+    cur = next;
+  }
+  float lanes0[W], lanes1[W], sines[W];
+  store(lanes0, acc0);
+  store(lanes1, acc1);
+  store(sines, prev);
+  float sum0 = 0.f, sum1 = 0.f;
+  for (int l = 0; l < W; l++) {
+    sum0 += lanes0[l];
+    sum1 += lanes1[l];
+  }
+  for (int l = 0; i + l < highest; l++) {
+    sum0 += amps0[i + l] * sines[l];
+    if (waves == 2)
+      sum1 += amps1[i + l] * sines[l];
+  }
+  wave[0] = sum0;
+  if (waves == 2)
+    wave[1] = sum1;
+}
+
+static void additive(int highest, float sine0, float sine1, float cosine,
+  const float* amps, int oscs, int waves, float* wave) {
+  if (waves == 1)
+    additiveWaves<1>(highest, sine0, sine1, cosine, amps, oscs, wave);
+  else
+    additiveWaves<2>(highest, sine0, sine1, cosine, amps, oscs, wave);
+}
+
+static void smoothen(float* __restrict y, const float* __restrict x, float k,
+  int n) {
+  for (int i = 0; i < n; i++)
+    y[i] += k * (x[i] - y[i]);
+}
+
+const DspKernels kernels = { additive, smoothen };
+
+}
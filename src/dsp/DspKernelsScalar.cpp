@@ -0,0 +1,7 @@
+// the scalar variant of the kernels, see DspKernels.h
+// (compiled without vectorization, see the Makefile)
+#define DSP_KERNELS_NAMESPACE DspKernelsScalar
+#define DSP_KERNELS_WIDTH 1
+#include "DspKernelsImpl.h"
+
+const DspKernels* getDspKernelsScalar() { return &DspKernelsScalar::kernels; }
@@ -0,0 +1,169 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// fast approximations of the elementary functions, for the audio thread
+// They are minimax polynomials (see computations/fastmath.py) in three
+// accuracy tiers. They have no branches, so loops calling them can be
+// vectorized by the compiler, and for whole arrays there are versions that
+// make sure of that.
+// The maximum errors below are measured in single precision, with
+// bench/fastmath.cpp (see `make bench`).
+namespace FastMath {
+
+enum Accuracy {
+  LOW,
+  MEDIUM,
+  HIGH
+};
+
+static constexpr float PI = M_PI;
+static constexpr float TWOPI = 2.f * M_PI;
+static constexpr float TWOPI_INV = 1.f / TWOPI;
+static constexpr float LOG2_10 = 3.32192809488736234787f;
+
+// sin(x), x in radians
+// absolute error for |x| <= pi: LOW 2.5e-4, MEDIUM 6.2e-6, HIGH 7.9e-7
+// For larger x the reduction to [-pi, pi] adds an error in the order of the
+// precision of x itself.
+template <Accuracy accuracy = HIGH>
+inline float sin(float x) {
+  x -= TWOPI * floorf(x * TWOPI_INV + .5f);
+  float x2 = x * x;
+  if (accuracy == LOW)
+    return x * (.99927586f + x2 * (-.16566697f + x2 * (7.9580589e-3f
+      + x2 * -1.4507679e-4f)));
+  if (accuracy == MEDIUM)
+    return x * (.99997939f + x2 * (-.16662438f + x2 * (8.3089848e-3f
+      + x2 * (-1.9264994e-4f + x2 * 2.1478720e-6f))));
+  return x * (.99999960f + x2 * (-.16666553f + x2 * (8.3324076e-3f
+    + x2 * (-1.9808740e-4f + x2 * (2.6998226e-6f + x2 * -2.0366224e-8f)))));
+}
+
+// cos(x), x in radians
+// absolute error for |x| <= pi: LOW 2.5e-4, MEDIUM 6.5e-6, HIGH 8.4e-7
+// (a little more than sin(), from rounding x + pi/2)
+template <Accuracy accuracy = HIGH>
+inline float cos(float x) {
+  return sin<accuracy>(x + .5f * PI);
+}
+
+// sin(2 pi x) and cos(2 pi x), for a phase x in periods
+// absolute error for |x| <= 16: LOW 2.6e-4, MEDIUM 6.4e-6, HIGH 7.2e-7 for
+// sin2pi(), LOW 2.5e-4, MEDIUM 6.0e-6, HIGH 2.2e-7 for cos2pi()
+// The reduction happens before the scaling, so the error doesn't grow with x.
+template <Accuracy accuracy = HIGH>
+inline float sin2pi(float x) {
+  return sin<accuracy>(TWOPI * (x - floorf(x + .5f)));
+}
+
+template <Accuracy accuracy = HIGH>
+inline float cos2pi(float x) {
+  // cos(2 pi x) = sin(2 pi (1/4 - |x|)) for |x| <= 1/2, with x reduced first,
+  // so that the quarter period isn't added to a large x
+  return sin<accuracy>(TWOPI * (.25f - fabsf(x - floorf(x + .5f))));
+}
+
+// 2^x
+// relative error for -125 <= x <= 126: LOW 7.5e-5, MEDIUM 2.7e-6,
+// HIGH 1.8e-7
+// x is clamped to [-126, 126], below -125 the result may be denormal.
+template <Accuracy accuracy = HIGH>
+inline float exp2(float x) {
+  // (fminf() and fmaxf() would keep the compiler from vectorizing this)
+  x = (x < -126.f) ? -126.f : ((x > 126.f) ? 126.f : x);
+  float xInt = floorf(x);
+  float f = x - xInt;
+  // 2^f for f in [0, 1)
+  float p;
+  if (accuracy == LOW)
+    p = .99992523f + f * (.69583349f + f * (.22606720f + f * 7.8024537e-2f));
+  else if (accuracy == MEDIUM)
+    p = 1.0000026f + f * (.69300384f + f * (.24144275f + f * (5.2011464e-2f
+      + f * 1.3534170e-2f)));
+  else
+    p = .99999993f + f * (.69315307f + f * (.24015362f + f * (5.5826317e-2f
+      + f * (8.9893403e-3f + f * 1.8775769e-3f))));
+  // 2^xInt, by writing the exponent bits of a float
+  union { int32_t i; float f; } scale;
+  scale.i = ((int32_t)xInt + 127) << 23;
+  return p * scale.f;
+}
+
+// log2(x), for normal x > 0
+// absolute error: LOW 1.0e-4, MEDIUM 1.4e-5, HIGH 4.9e-7
+template <Accuracy accuracy = HIGH>
+inline float log2(float x) {
+  // x = 2^e * m, with m in [1, 2)
+  union { float f; int32_t i; } bits;
+  bits.f = x;
+  float e = (float)(((bits.i >> 23) & 255) - 127);
+  bits.i = (bits.i & 0x007fffff) | 0x3f800000;
+  // log2(m) = t * p(t) with t = m - 1, so log2(1) = 0 exactly
+  float t = bits.f - 1.f;
+  float p;
+  if (accuracy == LOW)
+    p = 1.4390147f + t * (-.67994388f + t * (.32559529f + t * -8.4768394e-2f));
+  else if (accuracy == MEDIUM)
+    p = 1.4419656f + t * (-.70966275f + t * (.41759554f + t * (-.19626930f
+      + t * 4.6385202e-2f)));
+  else
+    p = 1.4426678f + t * (-.72058546f + t * (.47355338f + t * (-.32590187f
+      + t * (.19429415f + t * (-7.9557593e-2f + t * 1.5529874e-2f)))));
+  return e + t * p;
+}
+
+// 10^x (with x clamped to about +-37.9)
+// relative error for |x| <= 37: LOW 7.9e-5, MEDIUM 7.1e-6, HIGH 4.6e-6
+// That is the error of exp2(), plus the rounding of LOG2_10 * x, which adds
+// up to about 2e-7 * |x| (for |x| <= 1: HIGH 2.8e-7).
+template <Accuracy accuracy = HIGH>
+inline float pow10(float x) {
+  return exp2<accuracy>(LOG2_10 * x);
+}
+
+// the same functions for whole arrays, y[i] = f(x[i]) for i < n
+// (The arrays mustn't overlap, which lets the compiler vectorize the loops.)
+template <Accuracy accuracy = HIGH>
+inline void sin(const float* __restrict x, float* __restrict y, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = sin<accuracy>(x[i]);
+}
+
+template <Accuracy accuracy = HIGH>
+inline void cos(const float* __restrict x, float* __restrict y, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = cos<accuracy>(x[i]);
+}
+
+template <Accuracy accuracy = HIGH>
+inline void sin2pi(const float* __restrict x, float* __restrict y, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = sin2pi<accuracy>(x[i]);
+}
+
+template <Accuracy accuracy = HIGH>
+inline void cos2pi(const float* __restrict x, float* __restrict y, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = cos2pi<accuracy>(x[i]);
+}
+
+template <Accuracy accuracy = HIGH>
+inline void exp2(const float* __restrict x, float* __restrict y, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = exp2<accuracy>(x[i]);
+}
+
+template <Accuracy accuracy = HIGH>
+inline void log2(const float* __restrict x, float* __restrict y, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = log2<accuracy>(x[i]);
+}
+
+template <Accuracy accuracy = HIGH>
+inline void pow10(const float* __restrict x, float* __restrict y, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = pow10<accuracy>(x[i]);
+}
+
+}
@@ -39,6 +39,14 @@ public:
 
   virtual void process() = 0;
 
+  // advance the phases as if we had run for the given number of samples
+  void skip(int samples) {
+    for (int i = 0; i < phasors; i++) {
+      ph[i] += samples * dPh[i];
+      ph[i] -= floor(ph[i]);
+    }
+  }
+
   inline void reset() {
     for (int i = 0; i < phasors; i++)
       ph[i] = 0.;
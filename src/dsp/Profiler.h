@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// cycle counters for the stages of a module's process(), for finding out
+// where the time goes
+// They're only compiled in with VANTIES_PROFILE defined (`make PROFILE=1`).
+// Without it, the PROFILE_ macros below are empty and the modules don't have
+// a Profiler at all.
+// The audio thread adds up the cycles of each stage per sample, and every
+// WINDOW samples it publishes the average and the maximum per sample, which
+// the UI thread reads (see appendProfilerMenu() in vanTies.h).
+class Profiler {
+public:
+  enum Stage {
+    // the block-rate work: the CV buffer and the spectrum
+    CONTROL,
+    // smoothing the amplitudes or the CVs
+    SMOOTHING,
+    // the oscillators or the pendulums
+    SYNTHESIS,
+    // the output voltages and the display
+    OUTPUT,
+    STAGES_LEN
+  };
+
+  static constexpr int WINDOW = 1 << 14;
+
+#if defined(__x86_64__) || defined(__i386__)
+  static constexpr const char* UNIT = "cycles";
+  static uint64_t now() { return __rdtsc(); }
+#else
+  static constexpr const char* UNIT = "ns";
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+#endif
+
+  static const char* getName(Stage stage) {
+    static const char* NAMES[STAGES_LEN] = {
+      "Control", "Smoothing", "Synthesis", "Output"
+    };
+    return NAMES[stage];
+  }
+
+  // times the rest of the enclosing block
+  struct Scope {
+    Profiler& profiler;
+    Stage stage;
+    uint64_t start;
+
+    Scope(Profiler& profiler, Stage stage) :
+      profiler(profiler), stage(stage), start(now()) {}
+    ~Scope() { profiler.sample[stage] += now() - start; }
+  };
+
+  // Instead of a Scope: add the time since the last start() or lap() to
+  // stage, for timing consecutive pieces of code.
+  void start() { lapStart = now(); }
+  void lap(Stage stage) {
+    uint64_t t = now();
+    sample[stage] += t - lapStart;
+    lapStart = t;
+  }
+
+  // for the audio thread, at the end of process()
+  void endSample() {
+    for (int s = 0; s < STAGES_LEN; s++) {
+      sum[s] += sample[s];
+      if (sample[s] > max[s])
+        max[s] = sample[s];
+      sample[s] = 0;
+    }
+    if (++samples < WINDOW)
+      return;
+    for (int s = 0; s < STAGES_LEN; s++) {
+      publishedAverage[s].store((float)sum[s] / WINDOW,
+        std::memory_order_relaxed);
+      publishedMax[s].store((float)max[s], std::memory_order_relaxed);
+      sum[s] = 0;
+      max[s] = 0;
+    }
+    samples = 0;
+  }
+
+  // for the UI thread, per sample, over the last window
+  float getAverage(Stage stage) {
+    return publishedAverage[stage].load(std::memory_order_relaxed);
+  }
+  float getMax(Stage stage) {
+    return publishedMax[stage].load(std::memory_order_relaxed);
+  }
+
+private:
+  // only touched by the audio thread
+  uint64_t sample[STAGES_LEN] = {};
+  uint64_t sum[STAGES_LEN] = {};
+  uint64_t max[STAGES_LEN] = {};
+  int samples = 0;
+  uint64_t lapStart = 0;
+
+  std::atomic<float> publishedAverage[STAGES_LEN] = {};
+  std::atomic<float> publishedMax[STAGES_LEN] = {};
+};
+
+#ifdef VANTIES_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// Time the rest of the enclosing block as stage (CONTROL, SMOOTHING, ...).
+#define PROFILE_SCOPE(profiler, stage) \
+  Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)((profiler), \
+    Profiler::stage)
+#define PROFILE_START(profiler) (profiler).start()
+#define PROFILE_LAP(profiler, stage) (profiler).lap(Profiler::stage)
+#define PROFILE_END_SAMPLE(profiler) (profiler).endSample()
+#else
+#define PROFILE_SCOPE(profiler, stage)
+#define PROFILE_START(profiler)
+#define PROFILE_LAP(profiler, stage)
+#define PROFILE_END_SAMPLE(profiler)
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+// a small random number generator for the DSP classes
+// Unlike rand(), each instance has its own state and gives the same sequence
+// on every platform, so the offline renderer (see render/) can seed it and
+// get the same output on every run, on any number of threads. By default it
+// is seeded from rand(), so every instance starts differently.
+class Random {
+private:
+  std::minstd_rand rng;
+
+public:
+  Random() : rng((std::minstd_rand::result_type)rand()) {}
+
+  void seed(uint32_t seed) { rng.seed(seed); }
+
+  // uniformly distributed in [0, 1]
+  float uniform() {
+    return (float)(rng() - std::minstd_rand::min())
+      / (float)(std::minstd_rand::max() - std::minstd_rand::min());
+  }
+};
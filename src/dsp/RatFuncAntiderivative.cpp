@@ -0,0 +1,199 @@
+#include "RatFuncAntiderivative.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+typedef complex<double> cdouble;
+
+// the degree of a polynomial of degree <= 2, ignoring leading coefficients
+// which are negligible compared to the other ones
+// (We compare squared absolute values, norm() is a lot cheaper than abs().)
+static int degree(const cdouble* f) {
+  double m = max(max(norm(f[0]), norm(f[1])), norm(f[2]));
+  if (norm(f[2]) > 1.e-14 * m)
+    return 2;
+  if (norm(f[1]) > 1.e-14 * m)
+    return 1;
+  return 0;
+}
+
+// the roots of f[0] + f[1] * x + f[2] * x^2 , where f is of degree deg
+static int roots(const cdouble* f, int deg, cdouble* root) {
+  if (deg == 1) {
+    root[0] = -f[0] / f[1];
+    return 1;
+  } else if (deg == 2) {
+    // the numerically stable version of the quadratic formula
+    cdouble d = sqrt(f[1] * f[1] - 4. * f[2] * f[0]);
+    if (real(conj(f[1]) * d) < 0.)
+      d = -d;
+    cdouble q = -.5 * (f[1] + d);
+    root[0] = q / f[2];
+    root[1] = (norm(q) > 0.) ? f[0] / q : root[0];
+    return 2;
+  }
+  return 0;
+}
+
+static cdouble evalPoly(const cdouble* f, int deg, cdouble x) {
+  cdouble y = 0.;
+  for (int i = deg; i >= 0; i--)
+    y = y * x + f[i];
+  return y;
+}
+
+void RatFuncAntiderivative::Piece::init(const double* num,
+  const cdouble* factor1, const cdouble* factor2, double lead,
+  bool conjugates) {
+  const cdouble* factor[2] = { factor1, factor2 };
+  int deg[2] = { degree(factor1), degree(factor2) };
+
+  // the denominator: lead * factor1 * factor2
+  double den[5] = {};
+  for (int i = 0; i <= deg[0]; i++) {
+    for (int j = 0; j <= deg[1]; j++)
+      den[i + j] += lead * real(factor1[i] * factor2[j]);
+  }
+  int denDeg = deg[0] + deg[1];
+
+  // the polynomial part, by long division of the numerator by the
+  // denominator, and integrated right away
+  double rem[5];
+  for (int i = 0; i < 5; i++)
+    rem[i] = num[i];
+  for (int i = 0; i < 3; i++)
+    poly[i] = 0.;
+  for (int i = 4 - denDeg; i >= 0; i--) {
+    double q = rem[i + denDeg] / den[denDeg];
+    for (int j = 0; j <= denDeg; j++)
+      rem[i + j] -= q * den[j];
+    if (i < 3)
+      poly[i] = q / (i + 1.);
+  }
+
+  // the rest is a sum of fractions res / (x - root), and
+  // res = num(root) / den'(root)
+  // If the factors are conjugates, so are their roots and residues, so we
+  // only need the ones of the first factor, counted twice.
+  roots = 0;
+  for (int f = 0; f < (conjugates ? 1 : 2); f++) {
+    cdouble r[2];
+    int n = ::roots(factor[f], deg[f], r);
+    for (int i = 0; i < n; i++) {
+      cdouble dFactor = factor[f][1] + 2. * factor[f][2] * r[i];
+      if (deg[f] == 1)
+        dFactor = factor[f][1];
+      cdouble dDen = lead * dFactor * evalPoly(factor[1 - f], deg[1 - f], r[i]);
+      cdouble numR = 0.;
+      for (int j = 4; j >= 0; j--)
+        numR = numR * r[i] + num[j];
+      // nudge an exactly double root apart
+      if (dDen == 0.)
+        dDen = 1.e-300;
+      root[roots] = r[i];
+      res[roots] = numR / dDen;
+      weight[roots] = conjugates ? 2. : 1.;
+      roots++;
+    }
+  }
+
+  // A real root gives a real residue. A pair of complex conjugate roots gives
+  // a pair of conjugate residues, so we only need to keep one of them
+  // and count it twice.
+  for (int j = 0; j < roots; j++) {
+    if (imag(root[j]) * imag(root[j]) <= 1.e-24 * norm(root[j])) {
+      root[j] = real(root[j]);
+      res[j] = real(res[j]);
+      continue;
+    }
+    if (conjugates)
+      continue;
+    for (int k = j + 1; k < roots; k++) {
+      if (norm(root[k] - conj(root[j])) <= 1.e-18 * (1. + norm(root[j]))) {
+        weight[j] = 2.;
+        for (int l = k; l < roots - 1; l++) {
+          root[l] = root[l + 1];
+          res[l] = res[l + 1];
+          weight[l] = weight[l + 1];
+        }
+        roots--;
+        break;
+      }
+    }
+  }
+}
+
+double RatFuncAntiderivative::Piece::eval(double x) {
+  double y = x * (poly[0] + x * (poly[1] + x * poly[2]));
+  for (int j = 0; j < roots; j++) {
+    double re = x - real(root[j]);
+    double im = -imag(root[j]);
+    if (im == 0.)
+      y += weight[j] * real(res[j]) * log(abs(re));
+    else
+      y += weight[j] * (.5 * real(res[j]) * log(re * re + im * im)
+        - imag(res[j]) * atan2(im, re));
+  }
+  return y;
+}
+
+void RatFuncAntiderivative::init(double n, double d0, double d1, double d2,
+  double xHalf, double k, double q0, double q1, double q2) {
+  this->xHalf = xHalf;
+
+  // With u = M / D, where D is the denominator of phi and M is
+  // either n * x (for phi < .5) or D - n * x (for 1 - phi < .5), we get
+  //   g(u) = k * M * (2 * M - D) / (q0 * D^2 + q1 * M * D + q2 * M^2) .
+  // If s1 and s2 are the poles of g, i.e. the roots of
+  // q0 + q1 * s + q2 * s^2 , the denominator splits as
+  // q2 * (M - s1 * D) * (M - s2 * D) .
+  // We use the numerically stable version of the quadratic formula:
+  // s1 = r / q2 and s2 = q0 / r .
+  cdouble r = sqrt(cdouble(q1 * q1 - 4. * q2 * q0));
+  if (real(r) * q1 < 0.)
+    r = -r;
+  r = -.5 * (q1 + r);
+  // For a large pole s we write M - s * D = -s * (D - M / s) instead, to
+  // keep the coefficients of the factors in the same order of magnitude.
+  // So each factor is either M - s * D or D - (1 / s) * M .
+  bool large[2] = { norm(r) > q2 * q2, q0 * q0 > norm(r) };
+  cdouble s[2] = {
+    large[0] ? q2 / r : r / q2,
+    large[1] ? r / q0 : q0 / r
+  };
+  cdouble lead = large[0] ? -r : cdouble(q2);
+  if (large[1])
+    lead *= -q0 / r;
+
+  double D[3] = { d0, d1, d2 };
+  double M[2][3] = {
+    { 0., n, 0. },
+    { d0, d1 - n, d2 }
+  };
+  for (int p = 0; p < 2; p++) {
+    double sign = (p == 0) ? 1. : -1.;
+    double num[5] = {};
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++)
+        num[i + j] += sign * k * M[p][i] * (2. * M[p][j] - D[j]);
+    }
+
+    cdouble factor[2][3];
+    for (int f = 0; f < 2; f++) {
+      for (int i = 0; i < 3; i++)
+        factor[f][i] = large[f] ?
+        D[i] - s[f] * M[p][i] :
+        M[p][i] - s[f] * D[i];
+    }
+
+    // the leading factor is real: either both poles are real, or they are
+    // conjugates and we treated them in the same way
+    piece[p].init(num, factor[0], factor[1], real(lead), imag(s[0]) != 0.);
+  }
+
+  // make the whole thing continuous, starting at 0
+  offset[0] = piece[0].eval(0.);
+  offset[1] = piece[1].eval(xHalf) - piece[0].eval(xHalf) + offset[0];
+  total = eval(1.);
+}
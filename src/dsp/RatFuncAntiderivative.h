@@ -0,0 +1,51 @@
+#pragma once
+#include <complex>
+
+// a class for the antiderivative of one wave of the rational function
+// oscillator, for antiderivative anti-aliasing (ADAA)
+// The wave is the primary wave function g composed with a phase distortion
+//   phi(x) = n * x / (d0 + d1 * x + d2 * x^2) ,
+// where
+//   g(u) = k * u * (2 * u - 1) / (q0 + q1 * u + q2 * u^2)   on [0, .5] ,
+//   g(u) = -g(1 - u)                                        on [.5, 1] .
+// On both halves (phi < .5 and phi > .5) the composition is a rational
+// function in x, whose denominator splits into two quadratic factors, so we
+// can integrate it in closed form with partial fractions.
+// See computations/funs-adaa.sage .
+class RatFuncAntiderivative {
+public:
+  // xHalf is the point where phi(xHalf) = .5
+  void init(double n, double d0, double d1, double d2, double xHalf,
+    double k, double q0, double q1, double q2);
+
+  // the antiderivative on [0, 1], with F(0) = 0
+  double eval(double x) {
+    return (x < xHalf) ?
+      piece[0].eval(x) - offset[0] :
+      piece[1].eval(x) - offset[1];
+  }
+
+  // the integral over a whole period
+  double getTotal() { return total; }
+
+private:
+  // a rational function integrated as a polynomial and a sum of logarithms:
+  //   F(x) = poly[0] * x + poly[1] * x^2 + poly[2] * x^3
+  //     + sum_j weight[j] * Re(res[j] * log(x - root[j]))
+  struct Piece {
+    double poly[3] = {};
+    int roots = 0;
+    std::complex<double> root[4];
+    std::complex<double> res[4];
+    double weight[4] = {};
+
+    void init(const double* num, const std::complex<double>* factor1,
+      const std::complex<double>* factor2, double lead, bool conjugates);
+    double eval(double x);
+  };
+
+  Piece piece[2];
+  double offset[2] = {};
+  double xHalf = .5;
+  double total = 0.;
+};
@@ -1,4 +1,5 @@
 #include "RatFuncOscillator.h"
+#include "RatFuncWavetable.h"
 
 using namespace std;
 
@@ -125,6 +126,40 @@ float RatFuncOscillator::phaseDistortInv2(float x) {
   return y;
 }
 
+// set up the antiderivatives of the two waves,
+// see RatFuncAntiderivative.h and computations/funs-adaa.sage
+void RatFuncOscillator::initAntiderivatives() {
+  // the coefficients of the primary wave function
+  // k * u * (2 * u - 1) / (q0 + q1 * u + q2 * u^2)
+  // (in double precision: close to a double pole the partial fractions are
+  // very sensitive to these)
+  double a = this->a;
+  double b = this->b;
+  double sqrt2 = M_SQRT2;
+  double sqrt2m1 = sqrt2 - 1.;
+  double k = (a - b) * (a - b);
+  double q0 = a * a * (2. * sqrt2m1 * b * b - sqrt2m1 * b);
+  double q1 = -a * a - 4. * sqrt2m1 * a * b * b + 2. * sqrt2 * a * b - b * b;
+  double q2 = 2. * a * a - 4. * a * b + 2. * sqrt2 * b * b - sqrt2m1 * b;
+
+  // the phase distortion is phaseDistort1_1 or phaseDistort2_1, with
+  // c1 = c or 1 - c, which differ only in the sign of the square root
+  double c1 = (c > .5f) ? c : 1. - c;
+  double c2 = c1 * c1;
+  double c3 = c2 * c1;
+  double S = sqrt(max(c1 * (4. * c3 - 12. * c2 + 13. * c1 - 4.), 0.));
+  for (int i = 0; i < 2; i++) {
+    double sS = ((i == 0) == (c > .5f)) ? S : -S;
+    antiderivative[i].init(
+      2. * (c3 - 2. * c2 + c1),
+      c2 - sS * c1,
+      2. * c3 - 7. * c2 + 3. * c1 + sS * (1. + c1),
+      2. * c2 - c1 - sS,
+      c1,
+      k, q0, q1, q2);
+  }
+}
+
 // set the paramaters a, b, and c as values between 0. and 1.
 void RatFuncOscillator::setParams(float a, float b, float c) {
   a = min(max(a, 0.f), 1.f);
@@ -133,31 +168,87 @@ void RatFuncOscillator::setParams(float a, float b, float c) {
 
   // map the parameters in such a way that the worst aliasing is avoided
   // (lots of more or less educated guessing is going on here)
+  // With antiderivative or wavetable anti-aliasing we only need to stay away
+  // from the values where the functions degenerate.
+  float margin = (antiAliasing == LIMIT_PARAMS) ?
+    16.f * abs((float)dPh[0]) :
+    1.e-3f;
+  tableA = a;
+  tableB = b;
+  tableC = c;
 
   // exclude values of c around 0 and 1
-  float d = min(16.f * abs((float)dPh[0]), .5f);
+  float d = min(margin, .5f);
   c = min(max(c, d), 1.f - d);
 
   // range of a: (0, .5)
   a *= .5f;
   // exclude values of a around 0 and .5
-  d = min(16.f * abs((float)dPh[0]), .25f);
+  d = min(margin, .25f);
   a = min(max(a, d), .5f - .5f * d);
 
   // range of b: (a, .5)
   b = a + (.5f - a) * b;
   // exclude values of b around a and .5
-  d = min(16.f * abs((float)dPh[0]), .25f - .5f * a);
+  d = min(margin, .25f - .5f * a);
   b = min(max(b, a + d), .5f - d);
 
+  // Setting up the antiderivatives is relatively costly, so we don't follow
+  // tiny changes of the parameters.
+  if (antiAliasing == ANTIDERIVATIVE) {
+    if (antiderivativeChanged
+      || abs(a - this->a) > 1.e-4f
+      || abs(b - this->b) > 1.e-4f
+      || abs(c - this->c) > 1.e-4f) {
+      this->a = a;
+      this->b = b;
+      this->c = c;
+      initAntiderivatives();
+      antiderivativeChanged = true;
+    }
+    return;
+  }
+
   this->a = a;
   this->b = b;
   this->c = c;
 }
 
 void RatFuncOscillator::process() {
-  wave[0] = waveFunction1(ph[0]);
-  wave[1] = waveFunction2(ph[0]);
+  if (antiAliasing == ANTIDERIVATIVE) {
+    // first-order antiderivative anti-aliasing:
+    // the output is the average of the wave over the last phase increment,
+    // (F(ph[0]) - F(ph[0] - dPh[0])) / dPh[0] , where F is the antiderivative
+    double phPrev = ph[0];
+    if (antiderivativeChanged) {
+      antiderivativePrev[0] = antiderivative1(phPrev);
+      antiderivativePrev[1] = antiderivative2(phPrev);
+      antiderivativeChanged = false;
+    }
+    incrementPhases();
+
+    // the number of times the phase wrapped around
+    double wraps = round(phPrev + dPh[0] - ph[0]);
+    double F[2] = { antiderivative1(ph[0]), antiderivative2(ph[0]) };
+    for (int i = 0; i < 2; i++) {
+      if (abs(dPh[0]) > 1.e-6)
+        wave[i] = (F[i] - antiderivativePrev[i]
+          + wraps * getTotal(i)) / dPh[0];
+      else
+        wave[i] = (i == 0) ?
+        waveFunction1(phPrev + .5 * dPh[0]) :
+        waveFunction2(phPrev + .5 * dPh[0]);
+      antiderivativePrev[i] = F[i];
+    }
+  } else if (antiAliasing == WAVETABLE && wavetable
+    && wavetable->read(tableA, tableB, tableC,
+      RatFuncWavetable::getLevel(dPh[0]), ph[0], wave)) {
+    incrementPhases();
+  } else {
+    // (also while the wavetables are still being built)
+    wave[0] = waveFunction1(ph[0]);
+    wave[1] = waveFunction2(ph[0]);
 
-  incrementPhases();
+    incrementPhases();
+  }
 }
@@ -2,8 +2,18 @@
 #include <algorithm>
 #include <iostream>
 #include "Oscillator.h"
+#include "RatFuncAntiderivative.h"
+
+class RatFuncWavetable;
 
 class RatFuncOscillator : public Oscillator<1, 2> {
+public:
+  enum AntiAliasing {
+    LIMIT_PARAMS,
+    ANTIDERIVATIVE,
+    WAVETABLE
+  };
+
 private:
   float wave2;
 
@@ -11,6 +21,18 @@ private:
   float b;
   float c;
 
+  AntiAliasing antiAliasing = LIMIT_PARAMS;
+  // for antiderivative anti-aliasing
+  RatFuncAntiderivative antiderivative[2];
+  double antiderivativePrev[2] = {};
+  bool antiderivativeChanged = true;
+  // for wavetable anti-aliasing: the tables and the parameters as they were
+  // passed to setParams()
+  RatFuncWavetable* wavetable = nullptr;
+  float tableA = 0.f;
+  float tableB = 0.f;
+  float tableC = 0.f;
+
   static constexpr float SQRT2 = M_SQRT2;
   static constexpr float SQRT2M1 = SQRT2 - 1.f;
 
@@ -22,10 +44,28 @@ private:
   // only for puting the reference points on the oscilloscope widget
   float phaseDistortInv1_1(float x, float c1);
   float phaseDistortInv2_1(float x, float c1);
+  void initAntiderivatives();
 
 public:
   // set the paramaters a, b, and c as values between 0. and 1.
   void setParams(float a, float b, float c);
+  // set the parameters as they are after the mapping in setParams(), as
+  // returned by getA(), getB() and getC(), only for displaying the waves
+  void setShape(float a, float b, float c) {
+    this->a = a;
+    this->b = b;
+    this->c = c;
+  }
+  void setAntiAliasing(AntiAliasing antiAliasing) {
+    if (this->antiAliasing != antiAliasing)
+      antiderivativeChanged = true;
+    this->antiAliasing = antiAliasing;
+  }
+
+  AntiAliasing getAntiAliasing() { return antiAliasing; }
+  void setWavetable(RatFuncWavetable* wavetable) {
+    this->wavetable = wavetable;
+  }
 
   float getA() { return a; }
   float getB() { return b; }
@@ -39,6 +79,25 @@ public:
   float waveFunction2(float x) {
     return primaryWaveFunction(phaseDistort2(x));
   }
+  // the antiderivatives of the two waves, with value 0 at x = 0
+  // For c < .5 the waves are mirrored: wave(x) = -w(1 - x), so the
+  // antiderivative is W(1 - x) - W(1) .
+  double antiderivative1(double x) {
+    return (c > .5f) ?
+      antiderivative[0].eval(x) :
+      antiderivative[0].eval(1. - x) - antiderivative[0].getTotal();
+  }
+  double antiderivative2(double x) {
+    return (c > .5f) ?
+      antiderivative[1].eval(x) :
+      antiderivative[1].eval(1. - x) - antiderivative[1].getTotal();
+  }
+  // the integrals of the two waves over a whole period
+  double getTotal(int i) {
+    return (c > .5f) ?
+      antiderivative[i].getTotal() :
+      -antiderivative[i].getTotal();
+  }
   float phaseDistortInv1(float x);
   float phaseDistortInv2(float x);
   void process() override;
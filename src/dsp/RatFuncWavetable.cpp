@@ -0,0 +1,186 @@
+#include "RatFuncWavetable.h"
+#include <chrono>
+#include <complex>
+#include <mutex>
+#include "RatFuncOscillator.h"
+
+using namespace std;
+
+// an in-place radix-2 FFT, n should be a power of 2
+// We only use this in the background thread, so we keep it simple.
+static void fft(complex<double>* x, int n, bool inverse) {
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      swap(x[i], x[j]);
+  }
+  for (int len = 2; len <= n; len <<= 1) {
+    complex<double> dw = polar(1., (inverse ? 2. : -2.) * M_PI / len);
+    for (int i = 0; i < n; i += len) {
+      complex<double> w = 1.;
+      for (int j = 0; j < len / 2; j++) {
+        complex<double> u = x[i + j];
+        complex<double> v = x[i + j + len / 2] * w;
+        x[i + j] = u + v;
+        x[i + j + len / 2] = u - v;
+        w *= dw;
+      }
+    }
+  }
+}
+
+RatFuncWavetable::RatFuncWavetable() {
+  // mip level l has the harmonics below 1024 >> l, so it needs at least
+  // 2048 >> l samples, but we don't go below 64 samples to keep the linear
+  // interpolation accurate
+  int offset = 0;
+  for (int l = 0; l < LEVELS; l++) {
+    tableSize[l] = max(RENDER_SIZE >> l, 64);
+    for (int i = 0; i < 2; i++) {
+      tableOffset[l][i] = offset;
+      offset += tableSize[l] + 1;
+    }
+  }
+
+  for (int i = 0; i < POINTS; i++)
+    state[i].store(EMPTY);
+  pending.store(false);
+  running.store(true);
+  worker = thread(&RatFuncWavetable::work, this);
+}
+
+RatFuncWavetable::~RatFuncWavetable() {
+  running.store(false);
+  worker.join();
+}
+
+shared_ptr<RatFuncWavetable> RatFuncWavetable::acquire() {
+  static mutex sharedMutex;
+  static weak_ptr<RatFuncWavetable> shared;
+
+  lock_guard<mutex> lock(sharedMutex);
+  shared_ptr<RatFuncWavetable> wavetable = shared.lock();
+  if (!wavetable) {
+    wavetable = make_shared<RatFuncWavetable>();
+    shared = wavetable;
+  }
+  return wavetable;
+}
+
+void RatFuncWavetable::work() {
+  // an oscillator only for evaluating the wave functions
+  RatFuncOscillator osc;
+  osc.setAntiAliasing(RatFuncOscillator::WAVETABLE);
+
+  while (running.load()) {
+    if (!pending.exchange(false)) {
+      this_thread::sleep_for(chrono::milliseconds(10));
+      continue;
+    }
+    for (int i = 0; i < POINTS && running.load(); i++) {
+      if (state[i].load() == QUEUED) {
+        build(osc, i);
+        state[i].store(READY, memory_order_release);
+      }
+    }
+  }
+}
+
+void RatFuncWavetable::build(RatFuncOscillator& osc, int point) {
+  osc.setParams(
+    (float)(point % GRID) / (GRID - 1),
+    (float)(point / GRID % GRID) / (GRID - 1),
+    (float)(point / (GRID * GRID)) / (GRID - 1));
+
+  vector<float> table(tableOffset[LEVELS - 1][1] + tableSize[LEVELS - 1] + 1);
+  vector<complex<double>> spectrum(RENDER_SIZE);
+  vector<complex<double>> x(RENDER_SIZE);
+  for (int i = 0; i < 2; i++) {
+    for (int n = 0; n < RENDER_SIZE; n++) {
+      float ph = (float)n / RENDER_SIZE;
+      spectrum[n] = (i == 0) ? osc.waveFunction1(ph) : osc.waveFunction2(ph);
+    }
+    fft(spectrum.data(), RENDER_SIZE, false);
+
+    for (int l = 0; l < LEVELS; l++) {
+      // keep the harmonics below 1024 >> l and resynthesize
+      int harmonics = (RENDER_SIZE / 2) >> l;
+      int size = tableSize[l];
+      fill(x.begin(), x.begin() + size, complex<double>(0.));
+      x[0] = spectrum[0];
+      for (int k = 1; k < harmonics; k++) {
+        x[k] = spectrum[k];
+        x[size - k] = spectrum[RENDER_SIZE - k];
+      }
+      fft(x.data(), size, true);
+
+      float* t = &table[tableOffset[l][i]];
+      for (int n = 0; n < size; n++)
+        t[n] = real(x[n]) / RENDER_SIZE;
+      t[size] = t[0];
+    }
+  }
+  tables[point].swap(table);
+}
+
+bool RatFuncWavetable::request(int point) {
+  int s = state[point].load(memory_order_acquire);
+  if (s == READY)
+    return true;
+  if (s == EMPTY && state[point].compare_exchange_strong(s, QUEUED))
+    pending.store(true);
+  return false;
+}
+
+int RatFuncWavetable::getLevel(double dPh) {
+  // the smallest l with (1024 >> l) * |dPh| <= .5 , i.e. 2^l >= 2048 * |dPh|
+  float h = RENDER_SIZE * abs((float)dPh);
+  if (h <= 1.f)
+    return 0;
+  return min((int)ceilf(log2f(h)), LEVELS - 1);
+}
+
+bool RatFuncWavetable::read(float a, float b, float c, int level, float x,
+  float* wave) {
+  // the grid cell we're in, and the position within it
+  float p[3] = { a, b, c };
+  int i[3];
+  float f[3];
+  for (int j = 0; j < 3; j++) {
+    p[j] = min(max(p[j], 0.f), 1.f) * (GRID - 1);
+    i[j] = min((int)p[j], GRID - 2);
+    f[j] = p[j] - i[j];
+  }
+
+  int corner[8];
+  bool ready = true;
+  for (int k = 0; k < 8; k++) {
+    corner[k] = (i[0] + (k & 1))
+      + GRID * (i[1] + ((k >> 1) & 1))
+      + GRID * GRID * (i[2] + (k >> 2));
+    ready &= request(corner[k]);
+  }
+  if (!ready)
+    return false;
+
+  int size = tableSize[level];
+  float pos = x * size;
+  int n = min((int)pos, size - 1);
+  float frac = pos - n;
+
+  wave[0] = wave[1] = 0.f;
+  for (int k = 0; k < 8; k++) {
+    float weight =
+      ((k & 1) ? f[0] : 1.f - f[0])
+      * (((k >> 1) & 1) ? f[1] : 1.f - f[1])
+      * ((k >> 2) ? f[2] : 1.f - f[2]);
+    for (int w = 0; w < 2; w++) {
+      const float* t = &tables[corner[k]][tableOffset[level][w] + n];
+      wave[w] += weight * (t[0] + frac * (t[1] - t[0]));
+    }
+  }
+  return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class RatFuncOscillator;
+
+// band-limited wavetables of the two waves of the rational function
+// oscillator, on a coarse grid of the parameters a, b and c, with one mip
+// level per octave
+// The tables of a grid point are built by a background thread as soon as an
+// oscillator asks for them. They are shared by all the oscillators (and all
+// instances of Funs) which use the same RatFuncWavetable, see acquire().
+// When all the grid points are built this takes about 25 MB.
+class RatFuncWavetable {
+public:
+  // the number of grid points per parameter
+  static constexpr int GRID = 9;
+  static constexpr int POINTS = GRID * GRID * GRID;
+  // mip level l contains the harmonics below 1024 >> l
+  static constexpr int LEVELS = 10;
+  // the number of samples the waves are rendered with before band-limiting
+  static constexpr int RENDER_SIZE = 2048;
+
+private:
+  enum State {
+    EMPTY,
+    QUEUED,
+    READY
+  };
+
+  // the tables of all mip levels and both waves of a grid point,
+  // one after another, each with one extra sample for the interpolation
+  std::vector<float> tables[POINTS];
+  std::atomic<int> state[POINTS];
+  std::atomic<bool> pending;
+  std::atomic<bool> running;
+  std::thread worker;
+
+  int tableSize[LEVELS];
+  int tableOffset[LEVELS][2];
+
+  void work();
+  void build(RatFuncOscillator& osc, int point);
+  bool request(int point);
+
+public:
+  RatFuncWavetable();
+  ~RatFuncWavetable();
+
+  // a RatFuncWavetable shared with everyone else who acquired one and
+  // still holds on to it
+  static std::shared_ptr<RatFuncWavetable> acquire();
+
+  // the mip level for a phase increment dPh
+  static int getLevel(double dPh);
+
+  // Read the two waves at phase x, interpolated in the tables and across
+  // the grid. a, b and c are the parameters as passed to
+  // RatFuncOscillator::setParams(). If not all the tables we need are there
+  // yet, they get requested and we return false.
+  bool read(float a, float b, float c, int level, float x, float* wave);
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// a lock-free ring buffer of fixed size N (a power of 2), for passing a
+// stream of data from one producer thread (the audio thread) to one consumer
+// thread (the UI thread), where the consumer only cares about the latest
+// elements
+// The producer never waits and just overwrites the oldest elements. The
+// consumer reads the last few elements, which may get overwritten while it
+// reads them if it asks for nearly N of them, so it should leave a margin.
+template <typename T, int N>
+class RingBuffer {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of 2");
+
+private:
+  T data[N] = {};
+  // the number of elements pushed so far (wrapping around)
+  std::atomic<uint32_t> written{ 0 };
+
+public:
+  static constexpr int SIZE = N;
+
+  // for the producer:
+  void push(const T& x) {
+    uint32_t w = written.load(std::memory_order_relaxed);
+    data[w & (N - 1)] = x;
+    written.store(w + 1, std::memory_order_release);
+  }
+
+  // for the consumer:
+  // copy the last n elements (at most N) to out, the oldest first, and return
+  // how many there were
+  int read(T* out, int n) const {
+    uint32_t w = written.load(std::memory_order_acquire);
+    if (n > N)
+      n = N;
+    if ((uint32_t)n > w)
+      n = w;
+    for (int i = 0; i < n; i++)
+      out[i] = data[(w - n + i) & (N - 1)];
+    return n;
+  }
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include "FastMath.h"
+
+// a bank of up to 16 sine oscillators, for the fundamentals
+// Each oscillator is a quadrature rotor: the point (cos ph, sin ph) on the
+// unit circle, rotated by the phase increment every sample. That's two
+// multiplications and an addition per coordinate instead of a sine, and the
+// loop over the oscillators is vectorized by the compiler. The sine and cosine
+// of the phase increment are only computed when the frequency changes.
+class SineBank {
+public:
+  static constexpr int SIZE = 16;
+  // Rounding errors make the rotors drift off the unit circle, very slowly, so
+  // we pull them back every so many samples.
+  static constexpr int RENORM_INTERVAL = 64;
+
+private:
+  float sampleTime = 0.f;
+  // the number of oscillators we run, a multiple of 4
+  int size = SIZE;
+  int renormCounter = 0;
+
+  float cosPh[SIZE];
+  float sinPh[SIZE];
+  float dPh[SIZE];
+  float cosDPh[SIZE];
+  float sinDPh[SIZE];
+  // 1 below the Nyquist frequency, 0 above it
+  float gain[SIZE];
+  float wave[SIZE];
+
+public:
+  SineBank() {
+    for (int c = 0; c < SIZE; c++) {
+      dPh[c] = 0.f;
+      cosDPh[c] = 1.f;
+      sinDPh[c] = 0.f;
+      gain[c] = 1.f;
+      reset(c);
+    }
+  }
+
+  void setSampleRate(int sampleRate) {
+    sampleTime = 1.f / sampleRate;
+    // make setFreq() compute the rotations again
+    for (int c = 0; c < SIZE; c++)
+      dPh[c] = NAN;
+  }
+  // run only the first channels oscillators (rounded up to 4)
+  void setChannels(int channels) {
+    size = std::min((channels + 3) & ~3, SIZE);
+  }
+
+  void setFreq(int c, float freq) {
+    float dPh = freq * sampleTime;
+    if (dPh == this->dPh[c])
+      return;
+    this->dPh[c] = dPh;
+    cosDPh[c] = FastMath::cos2pi(dPh);
+    sinDPh[c] = FastMath::sin2pi(dPh);
+    gain[c] = (std::abs(dPh) < .5f) ? 1.f : 0.f;
+  }
+
+  float getWave(int c) { return wave[c]; }
+
+  void reset(int c) {
+    cosPh[c] = 1.f;
+    sinPh[c] = 0.f;
+    wave[c] = 0.f;
+  }
+
+  // advance all the oscillators as if we had run for the given number of
+  // samples (at their current frequencies)
+  void skip(int samples) {
+    for (int c = 0; c < SIZE; c++) {
+      // (in double precision, since this may be a lot of periods)
+      double ph = (double)samples * dPh[c];
+      ph = (ph == ph) ? ph - floor(ph) : 0.;
+      float cosSkip = FastMath::cos2pi((float)ph);
+      float sinSkip = FastMath::sin2pi((float)ph);
+      float cosPhNew = cosPh[c] * cosSkip - sinPh[c] * sinSkip;
+      sinPh[c] = sinPh[c] * cosSkip + cosPh[c] * sinSkip;
+      cosPh[c] = cosPhNew;
+    }
+  }
+
+  void process() {
+    for (int c = 0; c < size; c++) {
+      wave[c] = gain[c] * sinPh[c];
+      float cosPhNew = cosPh[c] * cosDPh[c] - sinPh[c] * sinDPh[c];
+      sinPh[c] = sinPh[c] * cosDPh[c] + cosPh[c] * sinDPh[c];
+      cosPh[c] = cosPhNew;
+    }
+
+    if (++renormCounter >= RENORM_INTERVAL) {
+      // one Newton step towards 1 / sqrt(cos^2 + sin^2), which is plenty,
+      // since we're very close to 1
+      for (int c = 0; c < size; c++) {
+        float k = 1.5f - .5f * (cosPh[c] * cosPh[c] + sinPh[c] * sinPh[c]);
+        cosPh[c] *= k;
+        sinPh[c] *= k;
+      }
+      renormCounter = 0;
+    }
+  }
+};
@@ -1,8 +1,45 @@
 #include "Spectrum.h"
+#include "FastMath.h"
+#include "DspKernels.h"
 
 using namespace std;
 
-void Spectrum::init(int oscs, CvBuffer* buf, int channels, int* partialChan) {
+// Distribute the partials over the left and right channels, in such a way
+// that for any value of the sieve parameter, the two channels are pretty much
+// in balance.
+// For 128 oscillators we need 127 ints (leave out the fundamental).
+const int Spectrum::PARTIAL_CHAN[2][127] = { {
+  1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+  1, 0, 1, 1, 0, 1, 0, 0, 0, 0,
+  0, 1, 1, 1, 1, 0, 1, 0, 0, 1,
+  1, 1, 0, 0, 1, 0, 1, 0, 1, 1,
+  1, 0, 0, 0, 0, 1, 0, 0, 1, 1,
+  1, 0, 1, 1, 1, 0, 1, 1, 0, 0,
+  0, 0, 0, 0, 0, 1, 0, 1, 1, 0,
+  0, 1, 1, 1, 1, 1, 1, 0, 0, 1,
+  0, 1, 0, 1, 1, 0, 0, 0, 1, 0,
+  0, 1, 0, 0, 0, 1, 1, 1, 0, 0,
+  0, 1, 1, 0, 1, 0, 1, 1, 0, 0,
+  1, 0, 1, 1, 1, 0, 0, 1, 1, 1,
+  1, 1, 0, 0, 0, 1, 1
+},{
+  0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+  0, 1, 0, 0, 1, 0, 1, 1, 1, 1,
+  1, 0, 0, 0, 0, 1, 0, 1, 1, 0,
+  0, 0, 1, 1, 0, 1, 0, 1, 0, 0,
+  0, 1, 1, 1, 1, 0, 1, 1, 0, 0,
+  0, 1, 0, 0, 0, 1, 0, 0, 1, 1,
+  1, 1, 1, 1, 1, 0, 1, 0, 0, 1,
+  1, 0, 0, 0, 0, 0, 0, 1, 1, 0,
+  1, 0, 1, 0, 0, 1, 1, 1, 0, 1,
+  1, 0, 1, 1, 1, 0, 0, 0, 1, 1,
+  1, 0, 0, 1, 0, 1, 0, 0, 1, 1,
+  0, 1, 0, 0, 0, 1, 1, 0, 0, 0,
+  0, 0, 1, 1, 1, 0, 0
+} };
+
+void Spectrum::init(int oscs, CvBuffer* buf, int channels,
+  const int* partialChan) {
   oscs = max(oscs, 0);
   this->oscs = oscs;
   channels = max(channels, 0);
@@ -18,9 +55,9 @@ void Spectrum::init(int oscs, CvBuffer* buf, int channels, int* partialChan) {
 }
 
 Spectrum::~Spectrum() {
-  delete amps_tmp;
-  delete amps;
-  delete ampsSmooth;
+  delete[] amps_tmp;
+  delete[] amps;
+  delete[] ampsSmooth;
 }
 
 void Spectrum::set0() {
@@ -31,18 +68,89 @@ void Spectrum::set0() {
     amps[i] = 0.f;
     ampsSmooth[i] = 0.f;
   }
+  zeroAmp = true;
+  silent = true;
+  setChanged();
+}
+
+void Spectrum::setStereoMode(StereoMode stereoMode) {
+  // The other channels haven't been kept up to date, so they continue from
+  // the first one.
+  if (this->stereoMode == MONO && stereoMode != MONO) {
+    for (int c = 1; c < channels; c++) {
+      for (int i = 0; i < oscs; i++) {
+        amps[i + oscs * c] = amps[i];
+        ampsSmooth[i + oscs * c] = ampsSmooth[i];
+      }
+    }
+  }
+  if (stereoMode != this->stereoMode)
+    setChanged();
+  this->stereoMode = stereoMode;
 }
 
 void Spectrum::smoothen() {
-  for (int i = 0; i < channels * oscs; i++)
-    ampsSmooth[i] += smoothCoeff * (amps[i] - ampsSmooth[i]);
+  if (silent)
+    return;
+
+  if (settled)
+    return;
+
+  int size = getActiveChannels() * oscs;
+  dspKernels->smoothen(ampsSmooth, amps, smoothCoeff, size);
+
+  // The normalized amplitudes are at most 1, so after silentAfter samples of
+  // 0 amplitudes, they've all decayed below SILENCE.
+  if (!zeroAmp)
+    silentCounter = 0;
+  else if (++silentCounter >= silentAfter) {
+    for (int i = 0; i < size; i++)
+      ampsSmooth[i] = 0.f;
+    silent = true;
+    return;
+  }
+  // The same goes for the distance to amplitudes that hold still.
+  if (++settledCounter >= silentAfter) {
+    for (int i = 0; i < size; i++)
+      ampsSmooth[i] = amps[i];
+    settled = true;
+  }
+}
+
+void Spectrum::getResult(Result& result) {
+  result.lowest = lowest;
+  result.highest = highest;
+  result.zeroAmp = zeroAmp;
+  result.stereoMode = stereoMode;
+  int size = min(getActiveChannels() * oscs, Result::MAX_SIZE);
+  for (int i = 0; i < size; i++)
+    result.amps[i] = amps[i];
+}
+
+void Spectrum::setResult(const Result& result) {
+  setLowestHighest(result.lowest, result.highest);
+  zeroAmp = result.zeroAmp;
+  if (!zeroAmp)
+    silent = false;
+  setStereoMode(result.stereoMode);
+  int size = min(getActiveChannels() * oscs, Result::MAX_SIZE);
+  bool changed = false;
+  for (int i = 0; i < size; i++)
+    setAmp(i, result.amps[i], changed);
+  if (changed)
+    setChanged();
 }
 
 void Spectrum::process() {
   for (int i = 0; i < lowestI - 1; i++)
     amps_tmp[i] = 0.f;
-  for (int i = lowestI - 1; i < highestI; i++)
-    amps_tmp[i] = powf(i + 1, tilt);
+  // The fundamental has amplitude 1 whatever the tilt: the tilt can be -inf,
+  // and then tilt * log2(1) would be NaN.
+  if (lowestI == 1 && highestI >= 1)
+    amps_tmp[0] = 1.f;
+  for (int i = max(lowestI - 1, 1); i < highestI; i++)
+    amps_tmp[i] = FastMath::exp2<FastMath::MEDIUM>(
+      tilt * FastMath::log2<FastMath::MEDIUM>(i + 1));
   for (int i = highestI; i < oscs + 1; i++)
     amps_tmp[i] = 0.f;
 
@@ -96,6 +204,8 @@ void Spectrum::process() {
   }
 
   zeroAmp = (sumAmp < 1.e-6f);
+  if (!zeroAmp)
+    silent = false;
   if (zeroAmp) {
     for (int i = lowestI - 1; i < highestI; i++)
       amps_tmp[i] = 0.f;
@@ -105,7 +215,8 @@ void Spectrum::process() {
     // and apply the fade factors again
     for (int i = lowestI - 1; i < highestI; i++) {
       amps_tmp[i] /= sumAmp;
-      amps_tmp[i] *= .5f * cosf(M_PI * comb * ((i + 1) - lowest)) + .5f;
+      amps_tmp[i] *= .5f * FastMath::cos2pi<FastMath::MEDIUM>(
+        .5f * comb * ((i + 1) - lowest)) + .5f;
       if (buf->isOn())
         amps_tmp[i] *= buf->getValue(i);
     }
@@ -118,32 +229,35 @@ void Spectrum::process() {
   }
 
   // copy the amplitude values to amps[] and apply panning
-  if (stereoMode == MONO) { // mono mode
-    for (int c = 0; c < channels; c++) {
-      for (int i = 0; i < oscs; i++)
-        amps[i + oscs * c] = amps_tmp[i];
-    }
+  bool changed = false;
+  if (stereoMode == MONO) { // mono mode, only the first channel
+    for (int i = 0; i < oscs; i++)
+      setAmp(i, amps_tmp[i], changed);
   } else if (stereoMode == SOFT_PAN) { // soft panned mode
     for (int c = 0; c < channels; c++) {
       // fundamental is present in all channels
-      amps[oscs * c] = amps_tmp[0];
+      setAmp(oscs * c, amps_tmp[0], changed);
       float l = (lowest > 2.f) ? lowest - 2.f : 0.f;
       for (int i = 1; i < oscs; i++)
-        amps[i + oscs * c] =
-        (c == partialChan[i - 1]) ?
-        amps_tmp[i] :
-        ((i + 1 > l) ? amps_tmp[i] / sqrtf(i + 1.f - l) : 0.f);
+        setAmp(i + oscs * c,
+          (c == partialChan[i - 1]) ?
+          amps_tmp[i] :
+          ((i + 1 > l) ? amps_tmp[i] / sqrtf(i + 1.f - l) : 0.f),
+          changed);
     }
   } else { // hard panned mode
     for (int c = 0; c < channels; c++) {
       // fundamental is present in all channels
-      amps[oscs * c] = amps_tmp[0];
+      setAmp(oscs * c, amps_tmp[0], changed);
       for (int i = 1; i < oscs; i++) {
-        amps[i + oscs * c] =
+        setAmp(i + oscs * c,
           (c == partialChan[i - 1]) ?
           amps_tmp[i] :
-          0.f;
+          0.f,
+          changed);
       }
     }
   }
+  if (changed)
+    setChanged();
 }
\ No newline at end of file
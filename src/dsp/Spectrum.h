@@ -10,7 +10,12 @@ public:
     HARD_PAN
   };
 
-  void init(int oscs, CvBuffer* buf, int channels = 1, int* partialChan = nullptr);
+  // partialChan tells for each partial but the fundamental on which of the
+  // two channels it goes, e.g. PARTIAL_CHAN[0] or PARTIAL_CHAN[1].
+  static const int PARTIAL_CHAN[2][127];
+
+  void init(int oscs, CvBuffer* buf, int channels = 1,
+    const int* partialChan = nullptr);
 
   ~Spectrum();
 
@@ -36,20 +41,55 @@ public:
   }
   inline void setSmoothCoeff(float smoothCoeff) {
     this->smoothCoeff = smoothCoeff;
+    // the number of samples it takes for an amplitude of 1 to decay below
+    // SILENCE
+    silentAfter = (smoothCoeff > 0.f && smoothCoeff < 1.f) ?
+      (int)ceilf(logf(SILENCE) / logf(1.f - smoothCoeff)) :
+      1;
   }
-  inline void setStereoMode(StereoMode stereoMode) {
-    this->stereoMode = stereoMode;
-  }
+  // In MONO mode we only fill in the first channel.
+  void setStereoMode(StereoMode stereoMode);
 
   inline int getLowest() { return lowestI; }
   inline int getHighest() { return highestI; }
   inline bool ampsAre0() { return zeroAmp; }
+  // true when the amplitudes are 0 and the smoothed ones have decayed to 0
+  // too, so the oscillator doesn't need to run
+  inline bool isSilent() { return silent; }
+  // true when the amplitudes haven't changed for a while and the smoothed
+  // ones have caught up with them, so they hold still
+  inline bool isSettled() { return settled; }
+  // changes whenever the amplitudes (or the stereo mode) do, so that
+  // something computed from them can tell whether it's still up to date
+  inline unsigned getVersion() { return version; }
   inline float getAmp(int i, int c = 0) { return ampsSmooth[i + c * oscs]; }
+  // all the smoothed amplitudes, channel c starting at c * getOscs()
+  inline const float* getAmps() { return ampsSmooth; }
+  inline int getOscs() { return oscs; }
   StereoMode getStereoMode() { return stereoMode; }
+  // the number of channels we actually fill in
+  inline int getActiveChannels() {
+    return (stereoMode == MONO) ? std::min(channels, 1) : channels;
+  }
 
   void process();
   void smoothen();
 
+  // the result of process(), for handing it over to another Spectrum of the
+  // same size, e.g. from a background thread to the audio thread
+  struct Result {
+    static constexpr int MAX_SIZE = 2 * 128;
+    float lowest;
+    float highest;
+    bool zeroAmp;
+    StereoMode stereoMode;
+    float amps[MAX_SIZE];
+  };
+  void getResult(Result& result);
+  // Take over the result of another Spectrum, as if we had run process()
+  // ourselves. We keep our own smoothed amplitudes.
+  void setResult(const Result& result);
+
 protected:
   StereoMode stereoMode = MONO;
   int channels = 0;
@@ -62,20 +102,41 @@ protected:
   int lowestI = 1;
   int highestI = 0;
   // an array we do our computations on:
-  float* amps_tmp;
+  float* amps_tmp = nullptr;
   // an array for the result of these computations:
-  float* amps;
+  float* amps = nullptr;
   // and an array where things are smoothened out (since we won't do these
   // at audio rate):
-  float* ampsSmooth;
+  float* ampsSmooth = nullptr;
   bool zeroAmp = true;
+  // The smoothed amplitudes are set to 0 once they've decayed below this
+  // (-100 dB).
+  static constexpr float SILENCE = 1.e-5f;
+  bool silent = true;
+  int silentCounter = 0;
+  int silentAfter = 1;
+  // Like silent, but for amplitudes that aren't 0. After silentAfter samples,
+  // the smoothed amplitudes are within SILENCE of the others.
+  bool settled = false;
+  int settledCounter = 0;
+  unsigned version = 0;
   float comb = 0.f;
   float smoothCoeff;
   // number of output channels (1 for mono, 2 for stereo)
-  int* partialChan;
+  const int* partialChan;
 
   CvBuffer* buf = nullptr;
 
+  inline void setAmp(int i, float amp, bool& changed) {
+    changed |= amps[i] != amp;
+    amps[i] = amp;
+  }
+  inline void setChanged() {
+    version++;
+    settled = false;
+    settledCounter = 0;
+  }
+
   // only for oscs <= 128
   const int PRIME[32] = {
     2, 3, 5, 7, 11, 13, 17, 19, 23, 29,
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// a lock-free queue of fixed capacity N (a power of 2), for passing messages
+// from one producer thread to one consumer thread
+// Unlike RingBuffer, nothing gets lost: when the queue is full, the producer
+// has to try again later. The elements are filled in and read in place (see
+// back() and front()), so big elements don't get copied around.
+template <typename T, int N>
+class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of 2");
+
+private:
+  T data[N];
+  // the number of elements pushed and popped so far (wrapping around)
+  std::atomic<uint32_t> pushed{ 0 };
+  std::atomic<uint32_t> popped{ 0 };
+
+public:
+  static constexpr int SIZE = N;
+
+  // for the producer:
+  // the element to fill in next, or nullptr when the queue is full
+  T* back() {
+    uint32_t p = pushed.load(std::memory_order_relaxed);
+    if (p - popped.load(std::memory_order_acquire) >= (uint32_t)N)
+      return nullptr;
+    return &data[p & (N - 1)];
+  }
+  // hand the element from back() over to the consumer
+  void push() {
+    pushed.store(pushed.load(std::memory_order_relaxed) + 1,
+      std::memory_order_release);
+  }
+  bool push(const T& x) {
+    T* b = back();
+    if (!b)
+      return false;
+    *b = x;
+    push();
+    return true;
+  }
+
+  // for the consumer:
+  // the oldest element, or nullptr when the queue is empty
+  T* front() {
+    uint32_t p = popped.load(std::memory_order_relaxed);
+    if (p == pushed.load(std::memory_order_acquire))
+      return nullptr;
+    return &data[p & (N - 1)];
+  }
+  // give the element from front() back to the producer
+  void pop() {
+    popped.store(popped.load(std::memory_order_relaxed) + 1,
+      std::memory_order_release);
+  }
+
+  // only when neither thread is using the queue
+  void clear() {
+    pushed.store(0);
+    popped.store(0);
+  }
+};
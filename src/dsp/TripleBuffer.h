@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+
+// a lock-free triple buffer, for passing data from one producer thread (the
+// audio thread) to one consumer thread (the UI thread)
+// The producer fills its back buffer and publishes it, the consumer picks up
+// the most recently published buffer. Neither of them ever has to wait.
+template <typename T>
+class TripleBuffer {
+private:
+  // a flag on the index of the middle buffer, telling that it hasn't been
+  // picked up yet
+  static constexpr int FRESH = 4;
+
+  T buffers[3];
+  int back = 0;
+  std::atomic<int> middle{ 1 };
+  int front = 2;
+
+public:
+  // for the producer:
+  // the buffer to fill (which still contains what was written in it three
+  // publications ago)
+  T& getBack() { return buffers[back]; }
+  void publish() {
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & 3;
+  }
+
+  // for the consumer:
+  // pick up the latest published buffer, returns false if there is nothing new
+  bool update() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH))
+      return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+    return true;
+  }
+  const T& getFront() { return buffers[front]; }
+};
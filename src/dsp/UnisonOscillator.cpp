@@ -0,0 +1,121 @@
+#include "UnisonOscillator.h"
+
+using namespace std;
+
+UnisonOscillator::UnisonOscillator() {
+  for (int k = 0; k < MAX_STACKS; k++) {
+    ratio[k] = 0.f;
+    for (int j = 0; j < 3; j++)
+      dPh[j][k] = 0.;
+  }
+  ratio[0] = 1.f;
+  reset();
+}
+
+void UnisonOscillator::setStacks(int stacks, float detune) {
+  stacks = min(max(stacks, 1), MAX_STACKS);
+  this->stacks = stacks;
+  this->detune = detune;
+  size = (stacks + 3) & ~3;
+  for (int k = 0; k < MAX_STACKS; k++)
+    ratio[k] = (k >= stacks) ? 0.f :
+    (stacks == 1) ? 1.f :
+    exp2f(detune / 1200.f * ((float)k / (stacks - 1) - .5f));
+  // The copies we drop must stand still at phase 0, where their sines are 0;
+  // anywhere else they'd add a constant to every partial.
+  for (int j = 0; j < 3; j++) {
+    for (int k = stacks; k < MAX_STACKS; k++) {
+      ph[j][k] = 0.;
+      dPh[j][k] = 0.;
+    }
+  }
+  // The copies start in phase after a reset, and come back into phase with
+  // every beat, so they add up in amplitude. Each copy is the same wave, so
+  // their average stays within the range of a single oscillator.
+  gain = 1.f / stacks;
+}
+
+void UnisonOscillator::process() {
+  // exclude partials oscillating faster than the Nyquist frequency, in the
+  // highest copy
+  double dPhMax = 0.;
+  for (int k = 0; k < stacks; k++)
+    dPhMax = max(dPhMax, abs(dPh[0][k]));
+  int highest = (abs(stretch) > 1.e-6f) ?
+    min(spec->getHighest(),
+      (int)floorf((.5f / dPhMax - 1.f) / abs(stretch)) + 1) :
+    ((dPhMax < .5) ? spec->getHighest() : 0);
+
+  bool mono = spec->getStereoMode() == Spectrum::MONO;
+  if (size == 4) {
+    if (mono)
+      processStacks<4, 1>(highest);
+    else
+      processStacks<4, 2>(highest);
+  } else {
+    if (mono)
+      processStacks<8, 1>(highest);
+    else
+      processStacks<8, 2>(highest);
+  }
+
+  for (int j = 0; j < 3; j++) {
+    for (int k = 0; k < size; k++) {
+      ph[j][k] += dPh[j][k];
+      ph[j][k] -= floor(ph[j][k]);
+    }
+  }
+}
+
+// the recursion of AdditiveOscillator::process(), for all the copies at once
+template <int size, int waves>
+void UnisonOscillator::processStacks(int highest) {
+  float cosine[size], sine_iMin2[size], sine_iMin1[size];
+  for (int k = 0; k < size; k++) {
+    cosine[k] = FastMath::cos2pi((float)ph[2][k]);
+    sine_iMin2[k] = (highest > 0) ? FastMath::sin2pi((float)ph[0][k]) : 0.f;
+    sine_iMin1[k] = (highest > 1) ? FastMath::sin2pi((float)ph[1][k]) : 0.f;
+  }
+  float sum0 = 0.f, sum1 = 0.f;
+  for (int k = 0; k < size; k++) {
+    sum0 += sine_iMin2[k];
+    sum1 += sine_iMin1[k];
+  }
+  for (int w = 0; w < waves; w++)
+    wave[w] = spec->getAmp(0, w) * sum0 + spec->getAmp(1, w) * sum1;
+
+  for (int i = 2; i < highest; i++) {
+    float sum = 0.f;
+    for (int k = 0; k < size; k++) {
+      float sine_i = 2.f * sine_iMin1[k] * cosine[k] - sine_iMin2[k];
+      sine_iMin2[k] = sine_iMin1[k];
+      sine_iMin1[k] = sine_i;
+      sum += sine_i;
+    }
+    for (int w = 0; w < waves; w++)
+      wave[w] += spec->getAmp(i, w) * sum;
+  }
+
+  for (int w = 0; w < waves; w++)
+    wave[w] *= gain;
+  if (waves == 1)
+    wave[1] = wave[0];
+}
+
+void UnisonOscillator::skip(int samples) {
+  for (int j = 0; j < 3; j++) {
+    for (int k = 0; k < MAX_STACKS; k++) {
+      ph[j][k] += samples * dPh[j][k];
+      ph[j][k] -= floor(ph[j][k]);
+    }
+  }
+}
+
+void UnisonOscillator::reset() {
+  for (int j = 0; j < 3; j++) {
+    for (int k = 0; k < MAX_STACKS; k++)
+      ph[j][k] = 0.;
+  }
+  wave[0] = 0.f;
+  wave[1] = 0.f;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include "Spectrum.h"
+#include "FastMath.h"
+
+// a stack of up to 8 detuned additive oscillators, all reading the same
+// spectrum
+// Each copy runs the recursion of AdditiveOscillator::process() on its own
+// phases. The copies are stored side by side (a structure of arrays) and the
+// loops run over them in lockstep, so that the compiler vectorizes them. The
+// amplitudes are the same for all copies, so for each partial we first sum the
+// sines of all copies and only then multiply by the amplitude: the spectrum
+// is read once, however many copies there are.
+class UnisonOscillator {
+public:
+  static constexpr int MAX_STACKS = 8;
+
+private:
+  float sampleTime = 0.f;
+  int stacks = 1;
+  float detune = 0.f;
+  // the number of copies we run, a multiple of 4; the ones beyond stacks
+  // have a frequency ratio of 0 and phase 0, so their sines stay 0
+  int size = 4;
+  float stretch = 0.f;
+  float gain = 1.f;
+
+  // the frequency of each copy, relative to the one set with setFreq()
+  float ratio[MAX_STACKS];
+  // the 3 phasors of AdditiveOscillator, for each copy
+  double ph[3][MAX_STACKS];
+  double dPh[3][MAX_STACKS];
+  float wave[2] = {};
+
+  Spectrum* spec = nullptr;
+
+  template <int size, int waves>
+  void processStacks(int highest);
+
+public:
+  UnisonOscillator();
+
+  void init(int sampleRate, Spectrum* spec) {
+    setSampleRate(sampleRate);
+    this->spec = spec;
+  }
+  void setSampleRate(int sampleRate) { sampleTime = 1.f / sampleRate; }
+
+  // Spread the copies evenly over detune cents, around the frequency.
+  void setStacks(int stacks, float detune);
+  int getStacks() { return stacks; }
+  float getDetune() { return detune; }
+
+  // The stretch is already quantized, see AdditiveOscillator::setStretch().
+  inline void setStretch(float stretch) { this->stretch = stretch; }
+  inline void setFreq(float freq) {
+    for (int k = 0; k < MAX_STACKS; k++) {
+      dPh[0][k] = ratio[k] * freq * sampleTime;
+      dPh[2][k] = stretch * dPh[0][k];
+      dPh[1][k] = dPh[0][k] + dPh[2][k];
+    }
+  }
+
+  inline float getWave(int i = 0) { return wave[i]; }
+
+  void process();
+  // advance the phases as if we had run for the given number of samples
+  void skip(int samples);
+  void reset();
+};
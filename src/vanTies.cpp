@@ -1,13 +1,45 @@
 #include "vanTies.h"
+#include "dsp/DspKernels.h"
 
 Plugin* pluginInstance;
 
 void init(Plugin* p) {
 	pluginInstance = p;
 
+	// Select the variant of the DSP kernels for this CPU.
+	DspKernels::init();
+
 	p->addModel(modelAd);
 	p->addModel(modelAdje);
 	p->addModel(modelBufke);
 	p->addModel(modelFuns);
 	p->addModel(modelSjoegele);
 }
+
+MenuItem* createControlRateMenuItem(ControlRate* controlRate) {
+	return createIndexPtrSubmenuItem(
+		"Control rate",
+		{ "1/16 of the sample rate",
+			"1/32 of the sample rate",
+			"1/64 of the sample rate",
+			"1/128 of the sample rate" },
+		controlRate);
+}
+
+#ifdef VANTIES_PROFILE
+void appendProfilerMenu(Menu* menu, Profiler* profiler) {
+	menu->addChild(new MenuSeparator);
+	menu->addChild(createSubmenuItem("Profile", "", [=](Menu* menu) {
+		menu->addChild(createMenuLabel(string::f("%s per sample, average / "
+			"maximum, over %d samples", Profiler::UNIT, Profiler::WINDOW)));
+		for (int s = 0; s < Profiler::STAGES_LEN; s++) {
+			Profiler::Stage stage = (Profiler::Stage)s;
+			if (profiler->getMax(stage) == 0.f)
+				continue;
+			menu->addChild(createMenuLabel(string::f("%s: %.0f / %.0f",
+				Profiler::getName(stage), profiler->getAverage(stage),
+				profiler->getMax(stage))));
+		}
+	}));
+}
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 #include <iostream>
 #include <rack.hpp>
+#include "dsp/Profiler.h"
+#include "dsp/ControlRate.h"
 
 using namespace rack;
 
@@ -13,3 +15,12 @@ extern Model* modelAdje;
 extern Model* modelBufke;
 extern Model* modelFuns;
 extern Model* modelSjoegele;
+
+// a submenu for choosing the control rate (see dsp/ControlRate.h)
+MenuItem* createControlRateMenuItem(ControlRate* controlRate);
+
+#ifdef VANTIES_PROFILE
+// a submenu with the average and maximum cycle counts of each stage of
+// process() that takes any time
+void appendProfilerMenu(Menu* menu, Profiler* profiler);
+#endif